@@ -393,6 +393,17 @@ struct cached_dev {
 	unsigned int		writeback_rate_fp_term_high;
 	unsigned int		writeback_rate_minimum;
 
+	/*
+	 * Backing device write latency seen by writeback, as an ewma in usec
+	 * shifted left by 8, and the latency above which writeback is slowed
+	 * down (0 to disable).
+	 */
+	uint64_t		writeback_latency_avg;
+	unsigned int		writeback_latency_target_us;
+	unsigned int		writeback_latency_throttled;
+	unsigned long		writeback_passes;
+	unsigned long		writeback_pass_keys;
+
 	enum stop_on_failure	stop_when_cache_set_failed;
 #define DEFAULT_CACHED_DEV_ERROR_LIMIT	64
 	atomic_t		io_errors;
@@ -127,6 +127,8 @@ rw_attribute(writeback_rate_fp_term_mid);
 rw_attribute(writeback_rate_fp_term_high);
 rw_attribute(writeback_rate_minimum);
 read_attribute(writeback_rate_debug);
+rw_attribute(writeback_latency_target_us);
+read_attribute(writeback_latency_us);
 
 read_attribute(stripe_size);
 read_attribute(partial_stripes_expensive);
@@ -213,6 +215,8 @@ SHOW(__bch_cached_dev)
 	var_print(writeback_rate_fp_term_mid);
 	var_print(writeback_rate_fp_term_high);
 	var_print(writeback_rate_minimum);
+	var_print(writeback_latency_target_us);
+	sysfs_print(writeback_latency_us, dc->writeback_latency_avg >> 8);
 
 	if (attr == &sysfs_writeback_rate_debug) {
 		char rate[20];
@@ -247,9 +251,16 @@ SHOW(__bch_cached_dev)
 			       "proportional:\t%s\n"
 			       "integral:\t%s\n"
 			       "change:\t\t%s/sec\n"
-			       "next io:\t%llims\n",
+			       "next io:\t%llims\n"
+			       "latency:\t%lluus\n"
+			       "throttled:\t%u\n"
+			       "keys/pass:\t%lu\n",
 			       rate, dirty, target, proportional,
-			       integral, change, next_io);
+			       integral, change, next_io,
+			       dc->writeback_latency_avg >> 8,
+			       dc->writeback_latency_throttled,
+			       dc->writeback_passes ?
+			       dc->writeback_pass_keys / dc->writeback_passes : 0);
 	}
 
 	sysfs_hprint(dirty_data,
@@ -351,6 +362,9 @@ STORE(__cached_dev)
 	sysfs_strtoul_clamp(writeback_rate_minimum,
 			    dc->writeback_rate_minimum,
 			    1, UINT_MAX);
+	sysfs_strtoul_clamp(writeback_latency_target_us,
+			    dc->writeback_latency_target_us,
+			    0, UINT_MAX);
 
 	sysfs_strtoul_clamp(io_error_limit, dc->error_limit, 0, INT_MAX);
 
@@ -524,6 +538,8 @@ static struct attribute *bch_cached_dev_attrs[] = {
 	&sysfs_writeback_rate_fp_term_high,
 	&sysfs_writeback_rate_minimum,
 	&sysfs_writeback_rate_debug,
+	&sysfs_writeback_latency_target_us,
+	&sysfs_writeback_latency_us,
 	&sysfs_io_errors,
 	&sysfs_io_error_limit,
 	&sysfs_io_disable,
@@ -87,6 +87,9 @@ static void __update_writeback_rate(struct cached_dev *dc)
 		div_s64(error, dc->writeback_rate_p_term_inverse);
 	int64_t integral_scaled;
 	uint32_t new_rate;
+	uint64_t latency = dc->writeback_latency_avg >> 8;
+	bool throttled = dc->writeback_latency_target_us &&
+			 latency > dc->writeback_latency_target_us;
 
 	/*
 	 * We need to consider the number of dirty buckets as well
@@ -127,13 +130,14 @@ static void __update_writeback_rate(struct cached_dev *dc)
 	}
 
 	if ((error < 0 && dc->writeback_rate_integral > 0) ||
-	    (error > 0 && time_before64(local_clock(),
+	    (error > 0 && !throttled && time_before64(local_clock(),
 			 dc->writeback_rate.next + NSEC_PER_MSEC))) {
 		/*
 		 * Only decrease the integral term if it's more than
 		 * zero.  Only increase the integral term if the device
-		 * is keeping up.  (Don't wind up the integral
-		 * ineffectively in either case).
+		 * is keeping up and isn't over its latency target.
+		 * (Don't wind up the integral ineffectively in either
+		 * case).
 		 *
 		 * It's necessary to scale this by
 		 * writeback_rate_update_seconds to keep the integral
@@ -149,6 +153,19 @@ static void __update_writeback_rate(struct cached_dev *dc)
 	new_rate = clamp_t(int32_t, (proportional_scaled + integral_scaled),
 			dc->writeback_rate_minimum, NSEC_PER_SEC);
 
+	/*
+	 * If the backing device is taking longer than the latency target
+	 * to complete our writes, we're flooding it: back the rate off in
+	 * proportion to how far over the target it is.
+	 */
+	if (throttled) {
+		new_rate = max_t(uint64_t, dc->writeback_rate_minimum,
+				 div64_u64((uint64_t)new_rate *
+					   dc->writeback_latency_target_us,
+					   latency));
+		dc->writeback_latency_throttled++;
+	}
+
 	dc->writeback_rate_proportional = proportional_scaled;
 	dc->writeback_rate_integral_scaled = integral_scaled;
 	dc->writeback_rate_change = new_rate -
@@ -323,9 +340,26 @@ struct dirty_io {
 	struct closure		cl;
 	struct cached_dev	*dc;
 	uint16_t		sequence;
+	uint64_t		write_start;
 	struct bio		bio;
 };
 
+static void writeback_update_latency(struct cached_dev *dc,
+				     struct dirty_io *io)
+{
+	uint64_t avg, us;
+
+	if (!io->write_start)
+		return;
+
+	us = div_u64(local_clock() - io->write_start, NSEC_PER_USEC);
+
+	/* Several writes may complete at once; an occasional lost update is fine */
+	avg = READ_ONCE(dc->writeback_latency_avg);
+	ewma_add(avg, us, 8, 8);
+	WRITE_ONCE(dc->writeback_latency_avg, avg);
+}
+
 static void dirty_init(struct keybuf_key *w)
 {
 	struct dirty_io *io = w->private;
@@ -354,6 +388,7 @@ static CLOSURE_CALLBACK(write_dirty_finish)
 	struct keybuf_key *w = io->bio.bi_private;
 	struct cached_dev *dc = io->dc;
 
+	writeback_update_latency(dc, io);
 	bio_free_pages(&io->bio);
 
 	/* This is kind of a dumb way of signalling errors. */
@@ -438,6 +473,7 @@ static CLOSURE_CALLBACK(write_dirty)
 		io->bio.bi_iter.bi_sector = KEY_START(&w->key);
 		bio_set_dev(&io->bio, io->dc->bdev);
 		io->bio.bi_end_io	= dirty_endio;
+		io->write_start		= local_clock();
 
 		/* I/O request sent to backing device */
 		closure_bio_submit(io->dc->disk.c, &io->bio, cl);
@@ -532,7 +568,13 @@ static void read_dirty(struct cached_dev *dc)
 			keys[nk++] = next;
 		} while ((next = bch_keybuf_next(&dc->writeback_keys)));
 
-		/* Now we have gathered a set of 1..5 keys to write back. */
+		dc->writeback_passes++;
+		dc->writeback_pass_keys += nk;
+
+		/*
+		 * Now we have gathered a set of 1..MAX_WRITEBACKS_IN_PASS
+		 * contiguous keys to write back.
+		 */
 		for (i = 0; i < nk; i++) {
 			w = keys[i];
 
@@ -20,6 +20,7 @@
 #include "time-utils.h"
 
 #include "config.h"
+#include "hash-utils.h"
 #include "indexer.h"
 
 /*
@@ -1414,11 +1415,18 @@ static void get_collision_name(const struct delta_index_entry *entry, u8 *name)
 {
 	u64 offset = get_delta_entry_offset(entry) + entry->entry_bits - COLLISION_BITS;
 	const u8 *addr = entry->delta_zone->memory + offset / BITS_PER_BYTE;
-	int size = COLLISION_BYTES;
 	int shift = offset % BITS_PER_BYTE;
+	u64 low = get_unaligned_le64(addr);
+	u64 high = get_unaligned_le64(addr + sizeof(u64));
+
+	/* Extract the name a word at a time; a shifted name spills into one more byte. */
+	if (shift > 0) {
+		low = (low >> shift) | (high << (64 - shift));
+		high = (high >> shift) | ((u64) addr[COLLISION_BYTES] << (64 - shift));
+	}
 
-	while (--size >= 0)
-		*name++ = get_unaligned_le16(addr++) >> shift;
+	put_unaligned_le64(low, name);
+	put_unaligned_le64(high, name + sizeof(u64));
 }
 
 static void set_collision_name(const struct delta_index_entry *entry, const u8 *name)
@@ -1471,7 +1479,8 @@ int uds_get_delta_index_entry(const struct delta_index *delta_index, u32 list_nu
 				break;
 
 			get_collision_name(&collision_entry, full_name);
-			if (memcmp(full_name, name, COLLISION_BYTES) == 0) {
+			if (uds_record_names_equal((const struct uds_record_name *) full_name,
+						   (const struct uds_record_name *) name)) {
 				*delta_entry = collision_entry;
 				break;
 			}
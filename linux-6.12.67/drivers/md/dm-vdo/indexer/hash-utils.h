@@ -63,4 +63,30 @@ static inline unsigned int uds_name_to_hash_slot(const struct uds_record_name *n
 	return (unsigned int) (uds_extract_chapter_index_bytes(name) % slot_count);
 }
 
+/*
+ * Record names are compared on every probe of the open chapter, the record pages, and the
+ * collision entries, so compare them eight bytes at a time rather than calling memcmp().
+ */
+static inline bool uds_record_names_equal(const struct uds_record_name *name1,
+					  const struct uds_record_name *name2)
+{
+	return ((get_unaligned_le64(&name1->name[0]) ^ get_unaligned_le64(&name2->name[0])) |
+		(get_unaligned_le64(&name1->name[8]) ^ get_unaligned_le64(&name2->name[8]))) == 0;
+}
+
+/* Order two record names the same way memcmp() would. */
+static inline int uds_compare_record_names(const struct uds_record_name *name1,
+					   const struct uds_record_name *name2)
+{
+	u64 word1 = get_unaligned_be64(&name1->name[0]);
+	u64 word2 = get_unaligned_be64(&name2->name[0]);
+
+	if (word1 == word2) {
+		word1 = get_unaligned_be64(&name1->name[8]);
+		word2 = get_unaligned_be64(&name2->name[8]);
+	}
+
+	return (word1 > word2) - (word1 < word2);
+}
+
 #endif /* UDS_HASH_UTILS_H */
@@ -120,7 +120,7 @@ static unsigned int probe_chapter_slots(struct open_chapter_zone *open_chapter,
 		 * deleted, then we've found the requested name.
 		 */
 		record = &open_chapter->records[record_number];
-		if ((memcmp(&record->name, name, UDS_RECORD_NAME_SIZE) == 0) &&
+		if (uds_record_names_equal(&record->name, name) &&
 		    !open_chapter->slots[record_number].deleted)
 			return slot;
 
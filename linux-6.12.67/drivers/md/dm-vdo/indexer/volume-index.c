@@ -458,7 +458,8 @@ static int get_volume_index_entry(struct volume_index_record *record, u32 list_n
 			if (result != UDS_SUCCESS)
 				return result;
 
-			if (memcmp(collision_name, record->name, UDS_RECORD_NAME_SIZE) == 0) {
+			if (uds_record_names_equal((const struct uds_record_name *) collision_name,
+						   record->name)) {
 				*record = other_record;
 				break;
 			}
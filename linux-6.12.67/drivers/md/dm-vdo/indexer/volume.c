@@ -482,7 +482,7 @@ static bool search_record_page(const u8 record_page[],
 		int result;
 		const struct uds_volume_record *record = &records[node];
 
-		result = memcmp(name, &record->name, UDS_RECORD_NAME_SIZE);
+		result = uds_compare_record_names(name, &record->name);
 		if (result == 0) {
 			if (metadata != NULL)
 				*metadata = record->data;
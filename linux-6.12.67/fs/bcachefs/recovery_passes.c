@@ -103,8 +103,11 @@ u64 bch2_recovery_passes_from_stable(u64 v)
 int bch2_run_explicit_recovery_pass(struct bch_fs *c,
 				    enum bch_recovery_pass pass)
 {
+	int ret = 0;
+
+	mutex_lock(&c->recovery_pass_lock);
 	if (c->opts.recovery_passes & BIT_ULL(pass))
-		return 0;
+		goto out;
 
 	bch_info(c, "running explicit recovery pass %s (%u), currently at %s (%u)",
 		 bch2_recovery_passes[pass], pass,
@@ -115,10 +118,11 @@ int bch2_run_explicit_recovery_pass(struct bch_fs *c,
 	if (c->curr_recovery_pass >= pass) {
 		c->curr_recovery_pass = pass;
 		c->recovery_passes_complete &= (1ULL << pass) >> 1;
-		return -BCH_ERR_restart_recovery;
-	} else {
-		return 0;
+		ret = -BCH_ERR_restart_recovery;
 	}
+out:
+	mutex_unlock(&c->recovery_pass_lock);
+	return ret;
 }
 
 int bch2_run_explicit_recovery_pass_persistent(struct bch_fs *c,
@@ -223,6 +227,92 @@ int bch2_run_online_recovery_passes(struct bch_fs *c)
 	return ret;
 }
 
+struct recovery_pass_work {
+	struct work_struct	work;
+	struct bch_fs		*c;
+	enum bch_recovery_pass	pass;
+	u64			end_time;
+	int			ret;
+};
+
+static void bch2_recovery_pass_work_fn(struct work_struct *work)
+{
+	struct recovery_pass_work *w =
+		container_of(work, struct recovery_pass_work, work);
+
+	w->ret = recovery_pass_fns[w->pass].fn(w->c);
+	w->end_time = local_clock();
+}
+
+/*
+ * Returns the number of consecutive passes starting at @pass that can be run
+ * as one parallel group: 0 if @pass should be run by itself.
+ */
+static unsigned bch2_recovery_pass_group(struct bch_fs *c, enum bch_recovery_pass pass)
+{
+	unsigned nr = 0;
+
+	/* Questions can't be asked from several passes at once: */
+	if (c->stdio || c->opts.fix_errors == FSCK_FIX_ask)
+		return 0;
+
+	while (pass + nr < ARRAY_SIZE(recovery_pass_fns) &&
+	       (recovery_pass_fns[pass + nr].when & PASS_PARALLEL) &&
+	       should_run_recovery_pass(c, pass + nr) &&
+	       !(c->opts.recovery_pass_last &&
+		 pass + nr > c->opts.recovery_pass_last))
+		nr++;
+
+	return nr > 1 ? nr : 0;
+}
+
+/*
+ * Run @nr recovery passes starting at @first concurrently, each on its own
+ * worker.  Returns the first error in pass order.
+ */
+static int bch2_run_recovery_passes_parallel(struct bch_fs *c,
+					     enum bch_recovery_pass first,
+					     unsigned nr)
+{
+	struct recovery_pass_work *w;
+	struct printbuf buf = PRINTBUF;
+	u64 start_time = local_clock();
+	unsigned i;
+	int ret = 0;
+
+	w = kcalloc(nr, sizeof(*w), GFP_KERNEL);
+	if (!w)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i++)
+		prt_printf(&buf, " %s", bch2_recovery_passes[first + i]);
+	bch_info(c, "running recovery passes in parallel:%s", buf.buf);
+	printbuf_exit(&buf);
+
+	for (i = 0; i < nr; i++) {
+		INIT_WORK(&w[i].work, bch2_recovery_pass_work_fn);
+		w[i].c		= c;
+		w[i].pass	= first + i;
+		queue_work(system_unbound_wq, &w[i].work);
+	}
+
+	for (i = 0; i < nr; i++) {
+		flush_work(&w[i].work);
+
+		if (w[i].ret && !ret)
+			ret = w[i].ret;
+	}
+
+	for (i = 0; i < nr; i++)
+		if (!w[i].ret)
+			bch_info(c, "%s done in %llu ms",
+				 bch2_recovery_passes[first + i],
+				 div_u64(w[i].end_time - start_time, NSEC_PER_MSEC));
+
+	kfree(w);
+	return ret;
+}
+
 int bch2_run_recovery_passes(struct bch_fs *c)
 {
 	int ret = 0;
@@ -238,6 +328,38 @@ int bch2_run_recovery_passes(struct bch_fs *c)
 		    c->curr_recovery_pass > c->opts.recovery_pass_last)
 			break;
 
+		unsigned nr = bch2_recovery_pass_group(c, c->curr_recovery_pass);
+		if (nr) {
+			unsigned pass = c->curr_recovery_pass;
+			unsigned last = pass + nr - 1;
+
+			/*
+			 * While the group runs we're at its last pass, so that a
+			 * pass asking for any pass in the group to be rerun
+			 * rewinds, as it would have if they'd run in order:
+			 */
+			c->curr_recovery_pass = last;
+
+			ret =   bch2_run_recovery_passes_parallel(c, pass, nr) ?:
+				bch2_journal_flush(&c->journal);
+			if (bch2_err_matches(ret, BCH_ERR_restart_recovery) ||
+			    (ret && c->curr_recovery_pass < last))
+				continue;
+			if (ret)
+				break;
+
+			for (unsigned i = pass; i <= last; i++) {
+				c->recovery_passes_complete |= BIT_ULL(i);
+
+				if (!test_bit(BCH_FS_error, &c->flags))
+					bch2_clear_recovery_pass_required(c, i);
+			}
+
+			c->recovery_pass_done = max(c->recovery_pass_done, c->curr_recovery_pass);
+			c->curr_recovery_pass++;
+			continue;
+		}
+
 		if (should_run_recovery_pass(c, c->curr_recovery_pass)) {
 			unsigned pass = c->curr_recovery_pass;
 
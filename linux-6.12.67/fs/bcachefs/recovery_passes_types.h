@@ -7,6 +7,12 @@
 #define PASS_UNCLEAN		BIT(2)
 #define PASS_ALWAYS		BIT(3)
 #define PASS_ONLINE		BIT(4)
+/*
+ * May run concurrently with adjacent PASS_PARALLEL passes: they must only
+ * touch btrees the other passes in the group don't repair, and not depend on
+ * each other's results:
+ */
+#define PASS_PARALLEL		BIT(5)
 
 /*
  * Passes may be reordered, but the second field is a persistent identifier and
@@ -43,9 +49,9 @@
 	x(fs_upgrade_for_subvolumes,		22, 0)				\
 	x(check_inodes,				24, PASS_FSCK)			\
 	x(check_extents,			25, PASS_FSCK)			\
-	x(check_indirect_extents,		26, PASS_FSCK)			\
+	x(check_indirect_extents,		26, PASS_FSCK|PASS_PARALLEL)	\
+	x(check_xattrs,				28, PASS_FSCK|PASS_PARALLEL)	\
 	x(check_dirents,			27, PASS_FSCK)			\
-	x(check_xattrs,				28, PASS_FSCK)			\
 	x(check_root,				29, PASS_ONLINE|PASS_FSCK)	\
 	x(check_unreachable_inodes,		40, PASS_ONLINE|PASS_FSCK)	\
 	x(check_subvolume_structure,		36, PASS_ONLINE|PASS_FSCK)	\
@@ -802,6 +802,8 @@ static struct bch_fs *bch2_fs_alloc(struct bch_sb *sb, struct bch_opts opts)
 	INIT_LIST_HEAD(&c->fsck_error_msgs);
 	mutex_init(&c->fsck_error_msgs_lock);
 
+	mutex_init(&c->recovery_pass_lock);
+
 	seqcount_init(&c->usage_lock);
 
 	sema_init(&c->io_in_flight, 128);
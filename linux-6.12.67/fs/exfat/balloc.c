@@ -69,6 +69,28 @@ static bool exfat_test_bitmap_range(struct super_block *sb, unsigned int clu,
 	return true;
 }
 
+/*
+ * Count the free clusters tracked by bitmap sector @i.  The last sector may
+ * cover fewer clusters than it has bits.
+ */
+static unsigned int exfat_count_free_in_sector(struct super_block *sb,
+		unsigned int i)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	unsigned int start = i * BITS_PER_SECTOR(sb);
+	unsigned int nbits = min_t(unsigned int, BITS_PER_SECTOR(sb),
+				   EXFAT_DATA_CLUSTER_COUNT(sbi) - start);
+	unsigned char *data = sbi->vol_amap[i]->b_data;
+	unsigned int used;
+
+	used = memweight(data, nbits / BITS_PER_BYTE);
+	if (nbits % BITS_PER_BYTE)
+		used += hweight8(data[nbits / BITS_PER_BYTE] &
+				 ((1 << (nbits % BITS_PER_BYTE)) - 1));
+
+	return nbits - used;
+}
+
 static int exfat_allocate_bitmap(struct super_block *sb,
 		struct exfat_dentry *ep)
 {
@@ -98,6 +120,14 @@ static int exfat_allocate_bitmap(struct super_block *sb,
 	if (!sbi->vol_amap)
 		return -ENOMEM;
 
+	sbi->vol_amap_free = kvmalloc_array(sbi->map_sectors,
+				sizeof(unsigned int), GFP_KERNEL);
+	if (!sbi->vol_amap_free) {
+		kvfree(sbi->vol_amap);
+		sbi->vol_amap = NULL;
+		return -ENOMEM;
+	}
+
 	sector = exfat_cluster_to_sector(sbi, sbi->map_clu);
 	for (i = 0; i < sbi->map_sectors; i++) {
 		sbi->vol_amap[i] = sb_bread(sb, sector + i);
@@ -109,6 +139,9 @@ static int exfat_allocate_bitmap(struct super_block *sb,
 		EXFAT_B_TO_CLU_ROUND_UP(map_size, sbi)) == false)
 		goto err_out;
 
+	for (j = 0; j < sbi->map_sectors; j++)
+		sbi->vol_amap_free[j] = exfat_count_free_in_sector(sb, j);
+
 	return 0;
 
 err_out:
@@ -117,6 +150,8 @@ err_out:
 	while (j < i)
 		brelse(sbi->vol_amap[j++]);
 
+	kvfree(sbi->vol_amap_free);
+	sbi->vol_amap_free = NULL;
 	kvfree(sbi->vol_amap);
 	sbi->vol_amap = NULL;
 	return -EIO;
@@ -167,6 +202,7 @@ void exfat_free_bitmap(struct exfat_sb_info *sbi)
 	for (i = 0; i < sbi->map_sectors; i++)
 		__brelse(sbi->vol_amap[i]);
 
+	kvfree(sbi->vol_amap_free);
 	kvfree(sbi->vol_amap);
 }
 
@@ -184,7 +220,8 @@ int exfat_set_bitmap(struct inode *inode, unsigned int clu, bool sync)
 	i = BITMAP_OFFSET_SECTOR_INDEX(sb, ent_idx);
 	b = BITMAP_OFFSET_BIT_IN_SECTOR(sb, ent_idx);
 
-	set_bit_le(b, sbi->vol_amap[i]->b_data);
+	if (!test_and_set_bit_le(b, sbi->vol_amap[i]->b_data))
+		sbi->vol_amap_free[i]--;
 	exfat_update_bh(sbi->vol_amap[i], sync);
 	return 0;
 }
@@ -208,6 +245,7 @@ int exfat_clear_bitmap(struct inode *inode, unsigned int clu, bool sync)
 		return -EIO;
 
 	clear_bit_le(b, sbi->vol_amap[i]->b_data);
+	sbi->vol_amap_free[i]++;
 
 	exfat_update_bh(sbi->vol_amap[i], sync);
 
@@ -230,10 +268,13 @@ int exfat_clear_bitmap(struct inode *inode, unsigned int clu, bool sync)
 /*
  * If the value of "clu" is 0, it means cluster 2 which is the first cluster of
  * the cluster heap.
+ *
+ * Bitmap sectors without any free cluster, according to vol_amap_free, are
+ * skipped as a whole instead of being scanned word by word.
  */
 unsigned int exfat_find_free_bitmap(struct super_block *sb, unsigned int clu)
 {
-	unsigned int i, map_i, map_b, ent_idx;
+	unsigned int i, map_i, map_b, ent_idx, nr_ent;
 	unsigned int clu_base, clu_free;
 	unsigned long clu_bits, clu_mask;
 	struct exfat_sb_info *sbi = EXFAT_SB(sb);
@@ -249,6 +290,16 @@ unsigned int exfat_find_free_bitmap(struct super_block *sb, unsigned int clu)
 
 	for (i = EXFAT_FIRST_CLUSTER; i < sbi->num_clusters;
 	     i += BITS_PER_LONG) {
+		if (!map_b && !sbi->vol_amap_free[map_i]) {
+			/* the loop adds BITS_PER_LONG to @i */
+			nr_ent = min_t(unsigned int, BITS_PER_SECTOR(sb),
+				       sbi->num_clusters - clu_base);
+			i += nr_ent - BITS_PER_LONG;
+			clu_base += nr_ent;
+			clu_mask = 0;
+			goto next_sector;
+		}
+
 		bitval = *(__le_long *)(sbi->vol_amap[map_i]->b_data + map_b);
 		if (clu_mask > 0) {
 			bitval |= cpu_to_lel(clu_mask);
@@ -265,6 +316,7 @@ unsigned int exfat_find_free_bitmap(struct super_block *sb, unsigned int clu)
 
 		if (map_b >= sb->s_blocksize ||
 		    clu_base >= sbi->num_clusters) {
+next_sector:
 			if (++map_i >= sbi->map_sectors) {
 				clu_base = EXFAT_FIRST_CLUSTER;
 				map_i = 0;
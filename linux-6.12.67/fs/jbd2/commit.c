@@ -158,6 +158,40 @@ static int journal_submit_commit_record(journal_t *journal,
 	return 0;
 }
 
+/*
+ * Flush of the filesystem device for an external journal.  It is submitted
+ * once the data buffers have been written and waited for only before the
+ * commit record goes out, so that it overlaps with the log block writes.
+ */
+struct jbd2_fs_flush {
+	struct bio		bio;
+	struct completion	done;
+};
+
+static void journal_end_fs_flush(struct bio *bio)
+{
+	struct jbd2_fs_flush *flush = bio->bi_private;
+
+	complete(&flush->done);
+}
+
+static void journal_submit_fs_flush(journal_t *journal,
+				    struct jbd2_fs_flush *flush)
+{
+	bio_init(&flush->bio, journal->j_fs_dev, NULL, 0,
+		 REQ_OP_WRITE | REQ_PREFLUSH);
+	init_completion(&flush->done);
+	flush->bio.bi_private = flush;
+	flush->bio.bi_end_io = journal_end_fs_flush;
+	submit_bio(&flush->bio);
+}
+
+static void journal_wait_on_fs_flush(struct jbd2_fs_flush *flush)
+{
+	wait_for_completion_io(&flush->done);
+	bio_uninit(&flush->bio);
+}
+
 /*
  * This function along with journal_submit_commit_record
  * allows to write the commit record asynchronously.
@@ -373,6 +407,8 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	tid_t first_tid;
 	int update_tail;
 	int csum_size = 0;
+	struct jbd2_fs_flush fs_flush;
+	bool fs_flush_pending = false;
 	LIST_HEAD(io_bufs);
 	LIST_HEAD(log_bufs);
 
@@ -777,14 +813,21 @@ start_journal_io:
 	 * If the journal is not located on the file system device,
 	 * then we must flush the file system device before we issue
 	 * the commit record and update the journal tail sequence.
+	 * The flush runs while we wait for the log blocks below.
 	 */
 	if ((commit_transaction->t_need_data_flush || update_tail) &&
 	    (journal->j_fs_dev != journal->j_dev) &&
-	    (journal->j_flags & JBD2_BARRIER))
-		blkdev_issue_flush(journal->j_fs_dev);
+	    (journal->j_flags & JBD2_BARRIER)) {
+		journal_submit_fs_flush(journal, &fs_flush);
+		fs_flush_pending = true;
+	}
 
 	/* Done it all: now write the commit record asynchronously. */
 	if (jbd2_has_feature_async_commit(journal)) {
+		if (fs_flush_pending) {
+			journal_wait_on_fs_flush(&fs_flush);
+			fs_flush_pending = false;
+		}
 		err = journal_submit_commit_record(journal, commit_transaction,
 						 &cbh, crc32_sum);
 		if (err)
@@ -877,6 +920,9 @@ start_journal_io:
 	commit_transaction->t_state = T_COMMIT_JFLUSH;
 	write_unlock(&journal->j_state_lock);
 
+	if (fs_flush_pending)
+		journal_wait_on_fs_flush(&fs_flush);
+
 	if (!jbd2_has_feature_async_commit(journal)) {
 		err = journal_submit_commit_record(journal, commit_transaction,
 						&cbh, crc32_sum);
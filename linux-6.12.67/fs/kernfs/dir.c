@@ -1880,9 +1880,151 @@ static int kernfs_fop_readdir(struct file *file, struct dir_context *ctx)
 	return 0;
 }
 
+/*
+ * Find the first file of @parent at or after @hash for KERNFS_IOC_BULK_READ.
+ * Must be called with kernfs_rwsem held.
+ */
+static struct kernfs_node *kernfs_bulk_pos(const void *ns,
+	struct kernfs_node *parent, loff_t hash)
+{
+	struct rb_node *node = parent->dir.children.rb_node;
+	struct kernfs_node *pos = NULL;
+
+	while (node) {
+		struct kernfs_node *kn = rb_to_kn(node);
+
+		if (hash <= kn->hash) {
+			pos = kn;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+
+	while (pos && (!kernfs_active(pos) || pos->ns != ns ||
+		       kernfs_type(pos) != KERNFS_FILE)) {
+		node = rb_next(&pos->rb);
+		pos = node ? rb_to_kn(node) : NULL;
+	}
+	return pos;
+}
+
+/* Return the file following @pos; kernfs_rwsem must be held. */
+static struct kernfs_node *kernfs_bulk_next_pos(const void *ns,
+	struct kernfs_node *parent, struct kernfs_node *pos)
+{
+	struct rb_node *node;
+
+	/* @pos may have been removed while kernfs_rwsem was dropped */
+	if (!kernfs_active(pos) || pos->parent != parent)
+		return kernfs_bulk_pos(ns, parent, pos->hash + 1);
+
+	do {
+		node = rb_next(&pos->rb);
+		pos = node ? rb_to_kn(node) : NULL;
+	} while (pos && (!kernfs_active(pos) || pos->ns != ns ||
+			 kernfs_type(pos) != KERNFS_FILE));
+	return pos;
+}
+
+/*
+ * Read the attribute files of a directory in one go.  Each file is read
+ * the same way read(2) on a freshly opened file would, but without setting
+ * up and tearing down a struct file for every attribute.
+ */
+static long kernfs_dir_bulk_read(struct file *file,
+				 struct kernfs_bulk_read __user *uarg)
+{
+	struct dentry *dentry = file->f_path.dentry;
+	struct kernfs_node *parent = kernfs_dentry_node(dentry);
+	struct kernfs_bulk_read req;
+	struct kernfs_node *pos, *next;
+	struct kernfs_root *root;
+	const void *ns = NULL;
+	char __user *ubuf;
+	size_t used = 0;
+	long err = 0;
+
+	if (copy_from_user(&req, uarg, sizeof(req)))
+		return -EFAULT;
+	if (req.flags || req.__reserved || req.cookie > KERNFS_BULK_READ_END)
+		return -EINVAL;
+
+	ubuf = u64_to_user_ptr(req.buf);
+	req.nr_records = 0;
+
+	root = kernfs_root(parent);
+	down_read(&root->kernfs_rwsem);
+
+	if (kernfs_ns_enabled(parent))
+		ns = kernfs_info(dentry->d_sb)->ns;
+
+	pos = NULL;
+	if (req.cookie < KERNFS_BULK_READ_END)
+		pos = kernfs_bulk_pos(ns, parent, req.cookie);
+
+	while (pos) {
+		ssize_t len;
+		char *name;
+
+		/* @pos may be renamed once kernfs_rwsem is dropped */
+		name = kstrdup(pos->name, GFP_KERNEL);
+		if (!name) {
+			req.cookie = pos->hash;
+			err = -ENOMEM;
+			break;
+		}
+
+		kernfs_get(pos);
+		up_read(&root->kernfs_rwsem);
+		len = kernfs_bulk_read_one(pos, name, file, ubuf + used,
+					   req.buf_len - used);
+		kfree(name);
+		down_read(&root->kernfs_rwsem);
+
+		if (len < 0) {
+			/* resume from @pos next time */
+			req.cookie = pos->hash;
+			kernfs_put(pos);
+			if (len != -ENOSPC)
+				err = len;
+			else if (!req.nr_records)
+				err = -EOVERFLOW;
+			break;
+		}
+
+		used += len;
+		req.nr_records++;
+		next = kernfs_bulk_next_pos(ns, parent, pos);
+		kernfs_put(pos);
+		pos = next;
+	}
+	if (!pos)
+		req.cookie = KERNFS_BULK_READ_END;
+	up_read(&root->kernfs_rwsem);
+
+	if (err)
+		return err;
+	if (copy_to_user(uarg, &req, sizeof(req)))
+		return -EFAULT;
+	return 0;
+}
+
+static long kernfs_dir_fop_ioctl(struct file *file, unsigned int cmd,
+				 unsigned long arg)
+{
+	switch (cmd) {
+	case KERNFS_IOC_BULK_READ:
+		return kernfs_dir_bulk_read(file, (void __user *)arg);
+	}
+	return -ENOTTY;
+}
+
 const struct file_operations kernfs_dir_fops = {
 	.read		= generic_read_dir,
 	.iterate_shared	= kernfs_fop_readdir,
+	.unlocked_ioctl	= kernfs_dir_fop_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
 	.release	= kernfs_dir_fop_release,
 	.llseek		= generic_file_llseek,
 };
@@ -298,6 +298,150 @@ static ssize_t kernfs_fop_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 	return kernfs_file_read_iter(iocb, iter);
 }
 
+/* largest attribute output returned by KERNFS_IOC_BULK_READ */
+#define KERNFS_BULK_SHOW_MAX	(16 * PAGE_SIZE)
+
+/*
+ * Run ->seq_show() of @kn into a private seq_file for KERNFS_IOC_BULK_READ.
+ * Only files which behave like single_open() and don't need per-open
+ * state are supported.  On success, the output is returned in *@bufp,
+ * which should be freed with kvfree(), and its length is returned.
+ */
+static ssize_t kernfs_bulk_show(struct kernfs_node *kn, char **bufp)
+{
+	const struct kernfs_ops *ops;
+	struct kernfs_open_file *of;
+	struct seq_file *sf;
+	size_t size = PAGE_SIZE;
+	ssize_t ret;
+
+	of = kzalloc(sizeof(*of), GFP_KERNEL);
+	sf = kzalloc(sizeof(*sf), GFP_KERNEL);
+	if (!of || !sf) {
+		ret = -ENOMEM;
+		goto out_free;
+	}
+
+	mutex_init(&of->mutex);
+	INIT_LIST_HEAD(&of->list);
+	of->kn = kn;
+	of->seq_file = sf;
+	mutex_init(&sf->lock);
+	sf->private = of;
+
+	if (!kernfs_get_active(kn)) {
+		ret = -ENODEV;
+		goto out_free;
+	}
+
+	ops = kernfs_ops(kn);
+	if (!(kn->flags & KERNFS_HAS_SEQ_SHOW) || ops->open ||
+	    ops->seq_start) {
+		ret = -EOPNOTSUPP;
+		goto out_put;
+	}
+
+	for (;;) {
+		sf->buf = kvmalloc(size, GFP_KERNEL_ACCOUNT);
+		if (!sf->buf) {
+			ret = -ENOMEM;
+			break;
+		}
+		sf->size = size;
+		sf->count = 0;
+
+		ret = ops->seq_show(sf, SEQ_START_TOKEN);
+		if (ret < 0)
+			break;
+		if (!seq_has_overflowed(sf)) {
+			ret = ret == SEQ_SKIP ? 0 : sf->count;
+			*bufp = sf->buf;
+			sf->buf = NULL;
+			break;
+		}
+
+		kvfree(sf->buf);
+		sf->buf = NULL;
+		if (size >= KERNFS_BULK_SHOW_MAX) {
+			ret = -EFBIG;
+			break;
+		}
+		size <<= 1;
+	}
+	kvfree(sf->buf);
+out_put:
+	kernfs_put_active(kn);
+out_free:
+	kfree(sf);
+	kfree(of);
+	return ret;
+}
+
+/**
+ * kernfs_bulk_read_one - emit a KERNFS_IOC_BULK_READ record for a file
+ * @kn: kernfs file to read
+ * @name: copy of @kn's name, taken under kernfs_rwsem
+ * @dir_file: the directory the ioctl was issued on
+ * @ubuf: userland buffer to store the record in
+ * @size: space left in @ubuf
+ *
+ * Errors reading the attribute itself, including lack of permission, are
+ * reported in the record.
+ *
+ * Return: the length of the record, -ENOSPC if it doesn't fit in @size or
+ * -EFAULT if it couldn't be copied out.
+ */
+ssize_t kernfs_bulk_read_one(struct kernfs_node *kn, const char *name,
+			     struct file *dir_file, char __user *ubuf,
+			     size_t size)
+{
+	struct kernfs_bulk_record rec = {};
+	size_t name_len = strlen(name);
+	struct inode *inode;
+	char *buf = NULL;
+	ssize_t len = 0;
+	size_t hdr_len;
+
+	inode = kernfs_get_inode(file_inode(dir_file)->i_sb, kn);
+	if (inode) {
+		rec.error = inode_permission(file_mnt_idmap(dir_file), inode,
+					     MAY_READ);
+		iput(inode);
+	} else {
+		rec.error = -ENOMEM;
+	}
+
+	if (!rec.error) {
+		len = kernfs_bulk_show(kn, &buf);
+		if (len < 0) {
+			rec.error = len;
+			len = 0;
+		}
+	}
+
+	hdr_len = sizeof(rec) + name_len;
+	rec.name_len = name_len;
+	rec.data_len = len;
+	rec.rec_len = ALIGN(hdr_len + len, 8);
+
+	if (rec.rec_len > size) {
+		len = -ENOSPC;
+		goto out;
+	}
+
+	if (copy_to_user(ubuf, &rec, sizeof(rec)) ||
+	    copy_to_user(ubuf + sizeof(rec), name, name_len) ||
+	    copy_to_user(ubuf + hdr_len, buf, len) ||
+	    clear_user(ubuf + hdr_len + len, rec.rec_len - hdr_len - len)) {
+		len = -EFAULT;
+		goto out;
+	}
+	len = rec.rec_len;
+out:
+	kvfree(buf);
+	return len;
+}
+
 /*
  * Copy data in from userland and pass it to the matching kernfs write
  * operation.
@@ -163,6 +163,9 @@ extern const struct file_operations kernfs_file_fops;
 
 bool kernfs_should_drain_open_files(struct kernfs_node *kn);
 void kernfs_drain_open_files(struct kernfs_node *kn);
+ssize_t kernfs_bulk_read_one(struct kernfs_node *kn, const char *name,
+			     struct file *dir_file, char __user *ubuf,
+			     size_t size);
 
 /*
  * symlink.c
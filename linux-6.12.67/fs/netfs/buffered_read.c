@@ -6,6 +6,7 @@
  */
 
 #include <linux/export.h>
+#include <linux/backing-dev.h>
 #include <linux/task_io_accounting_ops.h>
 #include "internal.h"
 
@@ -20,9 +21,118 @@ static void netfs_cache_expand_readahead(struct netfs_io_request *rreq,
 		cres->ops->expand_readahead(cres, _start, _len, i_size);
 }
 
+/*
+ * The largest adaptive readahead window we'll use for an inode.  We allow the
+ * window to grow past the bdi's readahead size so that a high-latency link can
+ * be kept busy, but keep it bounded so that a random reader isn't penalised.
+ */
+static unsigned int netfs_ra_max_window(struct netfs_io_request *rreq)
+{
+	unsigned long ra_pages = inode_to_bdi(rreq->inode)->ra_pages;
+
+	return umin((u64)ra_pages << (PAGE_SHIFT + 2), SZ_64M);
+}
+
+/*
+ * Extend a readahead request to cover the inode's adaptive readahead window so
+ * that enough data is in flight to fill the pipe to the server.  The request
+ * is never shrunk and is not extended past the EOF.
+ *
+ * Only a sequential stream is widened: the request must carry on from where
+ * the previous one ended, and neither random access advice nor page fault
+ * read-around (which bumps ra->mmap_miss) must be in effect.
+ */
+static void netfs_ra_apply_window(struct netfs_io_request *rreq,
+				  struct readahead_control *ractl)
+{
+	struct netfs_inode *ictx = netfs_inode(rreq->inode);
+	unsigned long long end, i_size = round_up(rreq->i_size, PAGE_SIZE);
+	unsigned int window = READ_ONCE(ictx->ra_window);
+
+	if (!window || rreq->len >= window)
+		return;
+	if (readahead_index(ractl) != READ_ONCE(ictx->ra_next))
+		return;
+	if (ractl->file && (ractl->file->f_mode & FMODE_RANDOM))
+		return;
+	if (ractl->ra && READ_ONCE(ractl->ra->mmap_miss))
+		return;
+
+	end = umin(rreq->start + window, i_size);
+	if (end > rreq->start + rreq->len) {
+		rreq->len = end - rreq->start;
+		netfs_stat(&netfs_n_rh_ra_expand);
+	}
+}
+
+/*
+ * Adjust the inode's adaptive readahead window from the aggregate download rate
+ * achieved by a completed readahead request.  Whilst widening the window keeps
+ * improving the rate, the link isn't yet saturated and the window is doubled;
+ * if the rate falls off significantly, the window is backed off by a quarter.
+ */
+void netfs_ra_note_completion(struct netfs_io_request *rreq)
+{
+	struct netfs_inode *ictx = netfs_inode(rreq->inode);
+	unsigned int window, rate, prev;
+	s64 usecs;
+
+	if (rreq->error || !rreq->transferred || !rreq->issue_time)
+		return;
+
+	window = READ_ONCE(ictx->ra_window);
+	if (rreq->len < window)
+		return; /* Not window-limited (eg. EOF), so tells us nothing */
+
+	usecs = umax(ktime_us_delta(ktime_get(), rreq->issue_time), 1);
+	rate = umin(div64_u64((u64)rreq->transferred * USEC_PER_MSEC, usecs), UINT_MAX);
+	prev = READ_ONCE(ictx->ra_rate);
+
+	if (!window)
+		window = umin(rreq->len, netfs_ra_max_window(rreq));
+	if (!prev || rate > prev + prev / 8) {
+		if (window < netfs_ra_max_window(rreq)) {
+			window = umin(window * 2, netfs_ra_max_window(rreq));
+			netfs_stat(&netfs_n_rh_ra_grow);
+		}
+	} else if (rate < prev - prev / 4) {
+		window = umax(window - window / 4, PAGE_SIZE);
+		netfs_stat(&netfs_n_rh_ra_shrink);
+	}
+
+	WRITE_ONCE(ictx->ra_rate, prev ? (prev * 3 + rate) / 4 : rate);
+	WRITE_ONCE(ictx->ra_window, window);
+}
+
+/*
+ * Work out the largest slice of a readahead request that we want to hand to
+ * the netfs in one subrequest.  Once the inode has an adaptive window, we
+ * cut the request into netfs_ra_slices slices of at least 256KiB so that
+ * several downloads can be issued together.  This only sizes the slices, it
+ * doesn't limit how many are in flight; the netfs may clip the slice further
+ * to its rsize.
+ */
+static size_t netfs_ra_slice_max(struct netfs_io_request *rreq)
+{
+	struct netfs_inode *ictx = netfs_inode(rreq->inode);
+	unsigned int nr = READ_ONCE(netfs_ra_slices);
+
+	if (rreq->origin != NETFS_READAHEAD || !READ_ONCE(ictx->ra_window) || nr <= 1)
+		return SIZE_MAX;
+	return umax(round_up(DIV_ROUND_UP_ULL(rreq->len, nr), PAGE_SIZE), SZ_256K);
+}
+
 static void netfs_rreq_expand(struct netfs_io_request *rreq,
 			      struct readahead_control *ractl)
 {
+	struct netfs_inode *ictx = netfs_inode(rreq->inode);
+
+	/* Grow the request to the adaptive window if the link needs more in
+	 * flight than the VM asked for.  Do this first so that the cache and
+	 * the netfs get to align the widened request.
+	 */
+	netfs_ra_apply_window(rreq, ractl);
+
 	/* Give the cache a chance to change the request parameters.  The
 	 * resultant request must contain the original region.
 	 */
@@ -52,6 +162,9 @@ static void netfs_rreq_expand(struct netfs_io_request *rreq,
 		trace_netfs_read(rreq, readahead_pos(ractl), readahead_length(ractl),
 				 netfs_read_trace_expanded);
 	}
+
+	/* A sequential reader's next readahead starts where this one ends. */
+	WRITE_ONCE(ictx->ra_next, readahead_index(ractl) + readahead_count(ractl));
 }
 
 /*
@@ -224,8 +337,10 @@ static void netfs_read_to_pagecache(struct netfs_io_request *rreq)
 	struct netfs_inode *ictx = netfs_inode(rreq->inode);
 	unsigned long long start = rreq->start;
 	ssize_t size = rreq->len;
+	size_t slice_max = netfs_ra_slice_max(rreq);
 	int ret = 0;
 
+	rreq->issue_time = ktime_get();
 	atomic_inc(&rreq->nr_outstanding);
 
 	do {
@@ -270,6 +385,10 @@ static void netfs_read_to_pagecache(struct netfs_io_request *rreq)
 				       subreq->start, ictx->zero_point, rreq->i_size);
 				break;
 			}
+			if (len > slice_max) {
+				len = slice_max;
+				netfs_stat(&netfs_n_rh_ra_split);
+			}
 			subreq->len = len;
 
 			netfs_stat(&netfs_n_rh_download);
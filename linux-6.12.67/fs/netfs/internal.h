@@ -25,11 +25,13 @@
  */
 int netfs_prefetch_for_write(struct file *file, struct folio *folio,
 			     size_t offset, size_t len);
+void netfs_ra_note_completion(struct netfs_io_request *rreq);
 
 /*
  * main.c
  */
 extern unsigned int netfs_debug;
+extern unsigned int netfs_ra_slices;
 extern struct list_head netfs_io_requests;
 extern spinlock_t netfs_proc_lock;
 extern mempool_t netfs_request_pool;
@@ -144,6 +146,10 @@ extern atomic_t netfs_n_wh_write_failed;
 extern atomic_t netfs_n_wb_lock_skip;
 extern atomic_t netfs_n_wb_lock_wait;
 extern atomic_t netfs_n_folioq;
+extern atomic_t netfs_n_rh_ra_grow;
+extern atomic_t netfs_n_rh_ra_shrink;
+extern atomic_t netfs_n_rh_ra_expand;
+extern atomic_t netfs_n_rh_ra_split;
 
 int netfs_stats_show(struct seq_file *m, void *v);
 
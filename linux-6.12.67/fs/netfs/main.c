@@ -24,6 +24,10 @@ unsigned netfs_debug;
 module_param_named(debug, netfs_debug, uint, S_IWUSR | S_IRUGO);
 MODULE_PARM_DESC(netfs_debug, "Netfs support debugging mask");
 
+unsigned int netfs_ra_slices = 8;
+module_param_named(ra_slices, netfs_ra_slices, uint, S_IWUSR | S_IRUGO);
+MODULE_PARM_DESC(ra_slices, "Number of slices (of at least 256KiB) a readahead request is cut into");
+
 static struct kmem_cache *netfs_request_slab;
 static struct kmem_cache *netfs_subrequest_slab;
 mempool_t netfs_request_pool;
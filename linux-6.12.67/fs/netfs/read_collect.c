@@ -379,6 +379,8 @@ static void netfs_rreq_assess(struct netfs_io_request *rreq)
 	if (rreq->origin == NETFS_DIO_READ ||
 	    rreq->origin == NETFS_READ_GAPS)
 		netfs_rreq_assess_dio(rreq);
+	else if (rreq->origin == NETFS_READAHEAD)
+		netfs_ra_note_completion(rreq);
 	task_io_account_read(rreq->transferred);
 
 	trace_netfs_rreq(rreq, netfs_rreq_trace_wake_ip);
@@ -43,6 +43,10 @@ atomic_t netfs_n_wh_write_failed;
 atomic_t netfs_n_wb_lock_skip;
 atomic_t netfs_n_wb_lock_wait;
 atomic_t netfs_n_folioq;
+atomic_t netfs_n_rh_ra_grow;
+atomic_t netfs_n_rh_ra_shrink;
+atomic_t netfs_n_rh_ra_expand;
+atomic_t netfs_n_rh_ra_split;
 
 int netfs_stats_show(struct seq_file *m, void *v)
 {
@@ -67,6 +71,11 @@ int netfs_stats_show(struct seq_file *m, void *v)
 		   atomic_read(&netfs_n_rh_download_done),
 		   atomic_read(&netfs_n_rh_download_failed),
 		   atomic_read(&netfs_n_rh_download_instead));
+	seq_printf(m, "RaWin  : gr=%u sh=%u ex=%u sp=%u\n",
+		   atomic_read(&netfs_n_rh_ra_grow),
+		   atomic_read(&netfs_n_rh_ra_shrink),
+		   atomic_read(&netfs_n_rh_ra_expand),
+		   atomic_read(&netfs_n_rh_ra_split));
 	seq_printf(m, "CaRdOps: RD=%u rs=%u rf=%u\n",
 		   atomic_read(&netfs_n_rh_read),
 		   atomic_read(&netfs_n_rh_read_done),
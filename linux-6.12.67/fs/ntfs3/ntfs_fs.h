@@ -118,6 +118,7 @@ struct runs_tree {
 	struct ntfs_run *runs;
 	size_t count; /* Currently used size a ntfs_run storage. */
 	size_t allocated; /* Currently allocated ntfs_run storage size. */
+	size_t hint; /* Index of the run last found by run_lookup. */
 };
 
 struct ntfs_buffers {
@@ -927,6 +928,7 @@ static inline void run_init(struct runs_tree *run)
 	run->runs = NULL;
 	run->count = 0;
 	run->allocated = 0;
+	run->hint = 0;
 }
 
 static inline struct runs_tree *run_alloc(void)
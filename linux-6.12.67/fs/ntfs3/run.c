@@ -24,6 +24,17 @@ struct ntfs_run {
 	CLST lcn; /* Logical cluster number. */
 };
 
+/*
+ * run_set_hint - Remember where the last lookup landed.
+ *
+ * The hint only speeds up run_lookup, so it is updated even through
+ * const runs_tree (e.g. lookups under a shared run_lock).
+ */
+static inline void run_set_hint(const struct runs_tree *run, size_t index)
+{
+	WRITE_ONCE(((struct runs_tree *)run)->hint, index);
+}
+
 /*
  * run_lookup - Lookup the index of a MCB entry that is first <= vcn.
  *
@@ -68,6 +79,34 @@ static bool run_lookup(const struct runs_tree *run, CLST vcn, size_t *index)
 		return true;
 	}
 
+	/*
+	 * Sequential access mostly hits the run found last time or the one
+	 * right after it. The hint may be stale, so check it against count.
+	 */
+	mid_idx = READ_ONCE(run->hint);
+	if (mid_idx + 1 < run->count) {
+		r = run->runs + mid_idx;
+		if (vcn >= r->vcn) {
+			if (vcn < r->vcn + r->len) {
+				*index = mid_idx;
+				return true;
+			}
+
+			r += 1;
+			if (vcn < r->vcn) {
+				/* Hole between two runs. */
+				*index = mid_idx + 1;
+				return false;
+			}
+
+			if (vcn < r->vcn + r->len) {
+				run_set_hint(run, mid_idx + 1);
+				*index = mid_idx + 1;
+				return true;
+			}
+		}
+	}
+
 	do {
 		mid_idx = min_idx + ((max_idx - min_idx) >> 1);
 		r = run->runs + mid_idx;
@@ -79,6 +118,7 @@ static bool run_lookup(const struct runs_tree *run, CLST vcn, size_t *index)
 		} else if (vcn >= r->vcn + r->len) {
 			min_idx = mid_idx + 1;
 		} else {
+			run_set_hint(run, mid_idx);
 			*index = mid_idx;
 			return true;
 		}
@@ -270,6 +270,7 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
+	bool try_offload = true;
 	int error = 0;
 
 	ovl_path_lowerdata(dentry, &datapath);
@@ -347,12 +348,35 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 		if (error)
 			break;
 
-		bytes = do_splice_direct(old_file, &old_pos,
-					 new_file, &new_pos,
-					 this_len, SPLICE_F_MOVE);
-		if (bytes <= 0) {
-			error = bytes;
-			break;
+		/*
+		 * Whole file clone failed, but the filesystems may still be
+		 * able to offload the copy (e.g. partial reflink or server
+		 * side copy).  If copy_file_range is not supported between
+		 * lower and upper, fall back to splice for the rest of the
+		 * file.
+		 */
+		bytes = 0;
+		if (try_offload) {
+			bytes = vfs_copy_file_range(old_file, old_pos,
+						    new_file, new_pos,
+						    this_len, 0);
+			if (bytes > 0) {
+				old_pos += bytes;
+				new_pos += bytes;
+			} else {
+				try_offload = false;
+				bytes = 0;
+			}
+		}
+
+		if (!bytes) {
+			bytes = do_splice_direct(old_file, &old_pos,
+						 new_file, &new_pos,
+						 this_len, SPLICE_F_MOVE);
+			if (bytes <= 0) {
+				error = bytes;
+				break;
+			}
 		}
 		WARN_ON(old_pos != new_pos);
 
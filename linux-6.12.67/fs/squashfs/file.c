@@ -34,6 +34,7 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -563,6 +564,133 @@ out:
 	return 1;
 }
 
+static void squashfs_readahead_block(struct inode *inode, struct page **pages,
+	unsigned int nr_pages, u64 block, int bsize, unsigned int expected,
+	loff_t start)
+{
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	loff_t file_end = i_size_read(inode) >> msblk->block_log;
+	struct squashfs_page_actor *actor;
+	struct page *last_page;
+	int i, res;
+
+	actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
+						expected, start);
+	if (!actor)
+		goto out;
+
+	res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
+
+	last_page = squashfs_page_actor_free(actor);
+
+	if (res == expected && !IS_ERR(last_page)) {
+		int bytes;
+
+		/* Last page (if present) may have trailing bytes not filled */
+		bytes = res % PAGE_SIZE;
+		if (start >> msblk->block_log == file_end && bytes && last_page)
+			memzero_page(last_page, bytes,
+				     PAGE_SIZE - bytes);
+
+		for (i = 0; i < nr_pages; i++) {
+			flush_dcache_page(pages[i]);
+			SetPageUptodate(pages[i]);
+		}
+	}
+
+out:
+	for (i = 0; i < nr_pages; i++) {
+		unlock_page(pages[i]);
+		put_page(pages[i]);
+	}
+}
+
+#ifdef CONFIG_SQUASHFS_PARALLEL_READAHEAD
+/*
+ * Parallel readahead.  Rather than decompressing each block of the
+ * readahead window in turn, the reading task only looks up the block list
+ * and hands each block (with its locked pages) to an unbound workqueue.
+ * The blocks are then decompressed concurrently on as many CPUs as the
+ * decompressor allows, and the pages of each block are unlocked as soon as
+ * that block is finished.
+ */
+static struct workqueue_struct *squashfs_readahead_wq;
+
+struct squashfs_readahead_work {
+	struct work_struct	work;
+	struct inode		*inode;
+	u64			block;
+	int			bsize;
+	unsigned int		expected;
+	loff_t			start;
+	unsigned int		nr_pages;
+	struct page		*pages[];
+};
+
+static void squashfs_readahead_worker(struct work_struct *work)
+{
+	struct squashfs_readahead_work *ra = container_of(work,
+				struct squashfs_readahead_work, work);
+
+	squashfs_readahead_block(ra->inode, ra->pages, ra->nr_pages, ra->block,
+				 ra->bsize, ra->expected, ra->start);
+	kfree(ra);
+}
+
+/*
+ * Queue the block for decompression by a worker.  Returns false if
+ * parallel readahead is not possible, in which case the caller should
+ * decompress the block itself.
+ */
+static bool squashfs_readahead_queue(struct inode *inode, struct page **pages,
+	unsigned int nr_pages, u64 block, int bsize, unsigned int expected,
+	loff_t start)
+{
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	struct squashfs_readahead_work *ra;
+
+	/* Nothing to be gained if only one decompressor can run */
+	if (!squashfs_readahead_wq || msblk->max_thread_num < 2)
+		return false;
+
+	ra = kmalloc(struct_size(ra, pages, nr_pages), GFP_NOIO);
+	if (!ra)
+		return false;
+
+	INIT_WORK(&ra->work, squashfs_readahead_worker);
+	ra->inode = inode;
+	ra->block = block;
+	ra->bsize = bsize;
+	ra->expected = expected;
+	ra->start = start;
+	ra->nr_pages = nr_pages;
+	memcpy(ra->pages, pages, nr_pages * sizeof(struct page *));
+
+	queue_work(squashfs_readahead_wq, &ra->work);
+	return true;
+}
+
+int __init squashfs_readahead_init(void)
+{
+	squashfs_readahead_wq = alloc_workqueue("squashfs_readahead",
+						WQ_UNBOUND, 0);
+
+	return squashfs_readahead_wq ? 0 : -ENOMEM;
+}
+
+void squashfs_readahead_destroy(void)
+{
+	destroy_workqueue(squashfs_readahead_wq);
+}
+#else
+static inline bool squashfs_readahead_queue(struct inode *inode,
+	struct page **pages, unsigned int nr_pages, u64 block, int bsize,
+	unsigned int expected, loff_t start)
+{
+	return false;
+}
+#endif
+
 static void squashfs_readahead(struct readahead_control *ractl)
 {
 	struct inode *inode = ractl->mapping->host;
@@ -571,7 +699,6 @@ static void squashfs_readahead(struct readahead_control *ractl)
 	unsigned short shift = msblk->block_log - PAGE_SHIFT;
 	loff_t start = readahead_pos(ractl) & ~mask;
 	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
-	struct squashfs_page_actor *actor;
 	unsigned int nr_pages = 0;
 	struct page **pages;
 	int i;
@@ -588,7 +715,6 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		int res, bsize;
 		u64 block = 0;
 		unsigned int expected;
-		struct page *last_page;
 
 		expected = start >> msblk->block_log == file_end ?
 			   (i_size_read(inode) & (msblk->block_size - 1)) :
@@ -616,34 +742,10 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		if (bsize == 0)
 			goto skip_pages;
 
-		actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
-							expected, start);
-		if (!actor)
-			goto skip_pages;
-
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
-
-		last_page = squashfs_page_actor_free(actor);
-
-		if (res == expected && !IS_ERR(last_page)) {
-			int bytes;
-
-			/* Last page (if present) may have trailing bytes not filled */
-			bytes = res % PAGE_SIZE;
-			if (start >> msblk->block_log == file_end && bytes && last_page)
-				memzero_page(last_page, bytes,
-					     PAGE_SIZE - bytes);
-
-			for (i = 0; i < nr_pages; i++) {
-				flush_dcache_page(pages[i]);
-				SetPageUptodate(pages[i]);
-			}
-		}
-
-		for (i = 0; i < nr_pages; i++) {
-			unlock_page(pages[i]);
-			put_page(pages[i]);
-		}
+		if (!squashfs_readahead_queue(inode, pages, nr_pages, block,
+					      bsize, expected, start))
+			squashfs_readahead_block(inode, pages, nr_pages, block,
+						 bsize, expected, start);
 
 		start += readahead_batch_length(ractl);
 	}
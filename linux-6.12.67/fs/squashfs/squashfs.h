@@ -70,6 +70,19 @@ extern __le64 *squashfs_read_fragment_index_table(struct super_block *,
 void squashfs_fill_page(struct page *, struct squashfs_cache_entry *, int, int);
 void squashfs_copy_cache(struct page *, struct squashfs_cache_entry *, int,
 				int);
+#ifdef CONFIG_SQUASHFS_PARALLEL_READAHEAD
+extern int squashfs_readahead_init(void);
+extern void squashfs_readahead_destroy(void);
+#else
+static inline int squashfs_readahead_init(void)
+{
+	return 0;
+}
+
+static inline void squashfs_readahead_destroy(void)
+{
+}
+#endif
 
 /* file_xxx.c */
 extern int squashfs_readpage_block(struct page *, u64, int, int);
@@ -78,19 +78,49 @@ static bool is_hash_block_verified(struct fsverity_info *vi, struct page *hpage,
 	return false;
 }
 
+/*
+ * The last verified level 0 hash block, kept while verifying a run of data
+ * blocks.  Consecutive data blocks usually have their hashes in the same
+ * level 0 block, so this avoids looking up the Merkle tree page and checking
+ * whether it is verified again for every data block.
+ */
+struct fsverity_hblock_cache {
+	struct page *hpage;
+	unsigned long hblock_idx;
+};
+
+static void hblock_cache_set(struct fsverity_hblock_cache *cache,
+			     struct page *hpage, unsigned long hblock_idx)
+{
+	if (cache->hpage)
+		put_page(cache->hpage);
+	cache->hpage = hpage;
+	cache->hblock_idx = hblock_idx;
+}
+
+static void hblock_cache_release(struct fsverity_hblock_cache *cache)
+{
+	if (cache->hpage)
+		put_page(cache->hpage);
+	cache->hpage = NULL;
+}
+
 /*
  * Verify a single data block against the file's Merkle tree.
  *
  * In principle, we need to verify the entire path to the root node.  However,
  * for efficiency the filesystem may cache the hash blocks.  Therefore we need
  * only ascend the tree until an already-verified hash block is seen, and then
- * verify the path to that block.
+ * verify the path to that block.  The level 0 hash block is handed over to
+ * @cache once verified, and reused directly if the next data block's hash is
+ * in the same block.
  *
  * Return: %true if the data block is valid, else %false.
  */
 static bool
 verify_data_block(struct inode *inode, struct fsverity_info *vi,
-		  const void *data, u64 data_pos, unsigned long max_ra_pages)
+		  const void *data, u64 data_pos, unsigned long max_ra_pages,
+		  struct fsverity_hblock_cache *cache)
 {
 	const struct merkle_tree_params *params = &vi->tree_params;
 	const unsigned int hsize = params->digest_size;
@@ -169,6 +199,16 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 		hoffset = (hidx << params->log_digestsize) &
 			  (params->block_size - 1);
 
+		if (level == 0 && cache->hpage &&
+		    cache->hblock_idx == hblock_idx) {
+			haddr = kmap_local_page(cache->hpage) +
+				hblock_offset_in_page;
+			memcpy(_want_hash, haddr + hoffset, hsize);
+			want_hash = _want_hash;
+			kunmap_local(haddr);
+			goto descend;
+		}
+
 		hpage = inode->i_sb->s_vop->read_merkle_tree_page(inode,
 				hpage_idx, level == 0 ? min(max_ra_pages,
 					params->tree_pages - hpage_idx) : 0);
@@ -183,7 +223,10 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 			memcpy(_want_hash, haddr + hoffset, hsize);
 			want_hash = _want_hash;
 			kunmap_local(haddr);
-			put_page(hpage);
+			if (level == 0)
+				hblock_cache_set(cache, hpage, hblock_idx);
+			else
+				put_page(hpage);
 			goto descend;
 		}
 		hblocks[level].page = hpage;
@@ -218,7 +261,10 @@ descend:
 		memcpy(_want_hash, haddr + hoffset, hsize);
 		want_hash = _want_hash;
 		kunmap_local(haddr);
-		put_page(hpage);
+		if (level == 1)
+			hblock_cache_set(cache, hpage, hblock_idx);
+		else
+			put_page(hpage);
 	}
 
 	/* Finally, verify the data block. */
@@ -244,7 +290,7 @@ error:
 
 static bool
 verify_data_blocks(struct folio *data_folio, size_t len, size_t offset,
-		   unsigned long max_ra_pages)
+		   unsigned long max_ra_pages, struct fsverity_hblock_cache *cache)
 {
 	struct inode *inode = data_folio->mapping->host;
 	struct fsverity_info *vi = inode->i_verity_info;
@@ -262,7 +308,7 @@ verify_data_blocks(struct folio *data_folio, size_t len, size_t offset,
 
 		data = kmap_local_folio(data_folio, offset);
 		valid = verify_data_block(inode, vi, data, pos + offset,
-					  max_ra_pages);
+					  max_ra_pages, cache);
 		kunmap_local(data);
 		if (!valid)
 			return false;
@@ -286,7 +332,12 @@ verify_data_blocks(struct folio *data_folio, size_t len, size_t offset,
  */
 bool fsverity_verify_blocks(struct folio *folio, size_t len, size_t offset)
 {
-	return verify_data_blocks(folio, len, offset, 0);
+	struct fsverity_hblock_cache cache = {};
+	bool valid;
+
+	valid = verify_data_blocks(folio, len, offset, 0, &cache);
+	hblock_cache_release(&cache);
+	return valid;
 }
 EXPORT_SYMBOL_GPL(fsverity_verify_blocks);
 
@@ -308,6 +359,7 @@ EXPORT_SYMBOL_GPL(fsverity_verify_blocks);
 void fsverity_verify_bio(struct bio *bio)
 {
 	struct folio_iter fi;
+	struct fsverity_hblock_cache cache = {};
 	unsigned long max_ra_pages = 0;
 
 	if (bio->bi_opf & REQ_RAHEAD) {
@@ -325,11 +377,12 @@ void fsverity_verify_bio(struct bio *bio)
 
 	bio_for_each_folio_all(fi, bio) {
 		if (!verify_data_blocks(fi.folio, fi.length, fi.offset,
-					max_ra_pages)) {
+					max_ra_pages, &cache)) {
 			bio->bi_status = BLK_STS_IOERR;
 			break;
 		}
 	}
+	hblock_cache_release(&cache);
 }
 EXPORT_SYMBOL_GPL(fsverity_verify_bio);
 #endif /* CONFIG_BLOCK */
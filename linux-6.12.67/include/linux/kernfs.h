@@ -19,6 +19,7 @@
 #include <linux/wait.h>
 #include <linux/rwsem.h>
 #include <linux/cache.h>
+#include <uapi/linux/kernfs.h>
 
 struct file;
 struct dentry;
@@ -19,6 +19,8 @@ struct ip_conntrack_stat {
 	unsigned int expect_delete;
 	unsigned int search_restart;
 	unsigned int chaintoolong;
+	unsigned int gc_scanned;
+	unsigned int gc_reaped;
 };
 
 #define NFCT_INFOMASK	7UL
@@ -66,6 +66,9 @@ struct netfs_inode {
 	loff_t			zero_point;	/* Size after which we assume there's no data
 						 * on the server */
 	atomic_t		io_count;	/* Number of outstanding reqs */
+	unsigned int		ra_window;	/* Adaptive readahead window (0 if unset) */
+	unsigned int		ra_rate;	/* Estimated readahead rate (bytes/ms) */
+	pgoff_t			ra_next;	/* Index after the last readahead request */
 	unsigned long		flags;
 #define NETFS_ICTX_ODIRECT	0		/* The file has DIO in progress */
 #define NETFS_ICTX_UNBUFFERED	1		/* I/O should not use the pagecache */
@@ -263,6 +266,7 @@ struct netfs_io_request {
 	u8			buffer_tail_slot; /* Next slot in ->buffer_tail */
 	unsigned long long	i_size;		/* Size of the file */
 	unsigned long long	start;		/* Start position */
+	ktime_t			issue_time;	/* When readahead I/O began to be issued */
 	atomic64_t		issued_to;	/* Write issuer folio cursor */
 	unsigned long long	collected_to;	/* Point we've collected to */
 	unsigned long long	cleaned_to;	/* Position we've cleaned folios to */
@@ -484,6 +488,9 @@ static inline void netfs_inode_init(struct netfs_inode *ctx,
 	ctx->zero_point = LLONG_MAX;
 	ctx->flags = 0;
 	atomic_set(&ctx->io_count, 0);
+	ctx->ra_window = 0;
+	ctx->ra_rate = 0;
+	ctx->ra_next = 0;
 #if IS_ENABLED(CONFIG_FSCACHE)
 	ctx->cache = NULL;
 #endif
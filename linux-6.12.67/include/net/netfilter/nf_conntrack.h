@@ -121,6 +121,12 @@ struct nf_conn {
 	/* Extensions */
 	struct nf_ct_ext *ext;
 
+	/* Expiry wheel linkage, protected by the lock of the wheel of
+	 * expiry_cpu.
+	 */
+	struct hlist_node	expiry_node;
+	u16			expiry_cpu;
+
 	/* Storage reserved for other modules, must be the last member */
 	union nf_conntrack_proto proto;
 };
@@ -206,6 +212,7 @@ bool nf_ct_get_tuplepr(const struct sk_buff *skb, unsigned int nhoff,
 void __nf_ct_refresh_acct(struct nf_conn *ct, enum ip_conntrack_info ctinfo,
 			  const struct sk_buff *skb,
 			  u32 extra_jiffies, bool do_acct);
+void nf_ct_set_expiry(struct nf_conn *ct, u32 timeout);
 
 /* Refresh conntrack for this many jiffies and do accounting */
 static inline void nf_ct_refresh_acct(struct nf_conn *ct,
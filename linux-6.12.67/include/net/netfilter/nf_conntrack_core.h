@@ -91,7 +91,7 @@ static inline void __nf_ct_set_timeout(struct nf_conn *ct, u64 timeout)
 		timeout = INT_MAX;
 
 	if (nf_ct_is_confirmed(ct))
-		WRITE_ONCE(ct->timeout, nfct_time_stamp + (u32)timeout);
+		nf_ct_set_expiry(ct, nfct_time_stamp + (u32)timeout);
 	else
 		ct->timeout = (u32)timeout;
 }
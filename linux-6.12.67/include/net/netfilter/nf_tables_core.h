@@ -80,6 +80,17 @@ struct nft_payload {
 
 extern const struct nft_expr_ops nft_payload_fast_ops;
 
+/* payload_fast load followed by a cmp_fast on the loaded register, fused
+ * into a single blob expression when the rule blob is built.
+ */
+struct nft_payload_cmp_fast_expr {
+	struct nft_payload		payload;	/* must be first */
+	struct nft_cmp_fast_expr	cmp;
+	u32				skip;
+};
+
+extern const struct nft_expr_ops nft_payload_cmp_fast_ops;
+
 extern const struct nft_expr_ops nft_bitwise_fast_ops;
 
 extern struct static_key_false nft_counters_enabled;
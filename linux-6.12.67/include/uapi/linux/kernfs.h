@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * kernfs user API
+ *
+ * KERNFS_IOC_BULK_READ can be issued on a directory of a kernfs based
+ * filesystem (sysfs, cgroupfs, ...) to read many of its attribute files in
+ * one call instead of one open/read/close per attribute.
+ */
+#ifndef _UAPI_LINUX_KERNFS_H
+#define _UAPI_LINUX_KERNFS_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * @buf and @buf_len describe the buffer which is filled with struct
+ * kernfs_bulk_record entries.  @cookie should be 0 on the first call and
+ * is updated to the position to resume from; it is set to
+ * KERNFS_BULK_READ_END once the whole directory has been read.
+ * @nr_records is set to the number of records stored in @buf.
+ */
+struct kernfs_bulk_read {
+	__u64 buf;
+	__u32 buf_len;
+	__u32 flags;
+	__u64 cookie;
+	__u32 nr_records;
+	__u32 __reserved;
+};
+
+#define KERNFS_BULK_READ_END	0x7fffffffULL
+
+/*
+ * One record per attribute file.  The record header is followed by
+ * @name_len bytes of the file name (not NUL terminated) and @data_len bytes
+ * of the file contents.  @rec_len is the total size of the record,
+ * including header and padding, and is a multiple of 8.  If the attribute
+ * could not be read, @error holds the negative errno and @data_len is 0;
+ * -EOPNOTSUPP means that the file must be read with read(2).
+ */
+struct kernfs_bulk_record {
+	__u32 rec_len;
+	__s32 error;
+	__u32 name_len;
+	__u32 data_len;
+};
+
+#define KERNFS_IOC_BULK_READ	_IOWR(0xdc, 1, struct kernfs_bulk_read)
+
+#endif /* _UAPI_LINUX_KERNFS_H */
@@ -21,6 +21,13 @@
 
 #define CHACHA_KEY_WORDS	(CHACHA_KEY_SIZE / sizeof(u32))
 
+/*
+ * Messages up to this length get their keystream, Poly1305 key block
+ * included, from a single ChaCha20 call, which the SIMD implementations
+ * process several blocks at a time instead of one block per call.
+ */
+#define CHACHA20POLY1305_SMALL_LEN	(3 * CHACHA_BLOCK_SIZE)
+
 static void chacha_load_key(u32 *k, const u8 *in)
 {
 	k[0] = get_unaligned_le32(in);
@@ -213,6 +220,8 @@ bool chacha20poly1305_crypt_sg_inplace(struct scatterlist *src,
 				       int encrypt)
 {
 	const u8 *pad0 = page_address(ZERO_PAGE(0));
+	u8 stream[CHACHA_BLOCK_SIZE + CHACHA20POLY1305_SMALL_LEN] __aligned(16);
+	const bool small = src_len <= CHACHA20POLY1305_SMALL_LEN;
 	struct poly1305_desc_ctx poly1305_state;
 	u32 chacha_state[CHACHA_STATE_WORDS];
 	struct sg_mapping_iter miter;
@@ -242,8 +251,14 @@ bool chacha20poly1305_crypt_sg_inplace(struct scatterlist *src,
 	b.iv[1] = cpu_to_le64(nonce);
 
 	chacha_init(chacha_state, b.k, (u8 *)b.iv);
-	chacha20_crypt(chacha_state, b.block0, pad0, sizeof(b.block0));
-	poly1305_init(&poly1305_state, b.block0);
+	if (small) {
+		chacha20_crypt(chacha_state, stream, pad0,
+			       CHACHA_BLOCK_SIZE + src_len);
+		poly1305_init(&poly1305_state, stream);
+	} else {
+		chacha20_crypt(chacha_state, b.block0, pad0, sizeof(b.block0));
+		poly1305_init(&poly1305_state, b.block0);
+	}
 
 	if (unlikely(ad_len)) {
 		poly1305_update(&poly1305_state, ad, ad_len);
@@ -262,6 +277,12 @@ bool chacha20poly1305_crypt_sg_inplace(struct scatterlist *src,
 		if (!encrypt)
 			poly1305_update(&poly1305_state, addr, length);
 
+		if (small) {
+			crypto_xor(addr, stream + CHACHA_BLOCK_SIZE + src_len - sl,
+				   length);
+			length = 0;
+		}
+
 		if (unlikely(partial)) {
 			size_t l = min(length, CHACHA_BLOCK_SIZE - partial);
 
@@ -326,6 +347,8 @@ bool chacha20poly1305_crypt_sg_inplace(struct scatterlist *src,
 
 	memzero_explicit(chacha_state, sizeof(chacha_state));
 	memzero_explicit(&b, sizeof(b));
+	if (small)
+		memzero_explicit(stream, CHACHA_BLOCK_SIZE + src_len);
 
 	return ret;
 }
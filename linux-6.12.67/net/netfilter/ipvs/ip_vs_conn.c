@@ -32,6 +32,9 @@
 #include <linux/jhash.h>
 #include <linux/random.h>
 #include <linux/rcupdate_wait.h>
+#include <linux/percpu_counter.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
 
 #include <net/net_namespace.h>
 #include <net/ip_vs.h>
@@ -42,20 +45,40 @@
 #endif
 
 /*
- * Connection hash size. Default is what was selected at compile time.
+ * Initial connection hash size. Default is what was selected at compile time.
 */
 static int ip_vs_conn_tab_bits = CONFIG_IP_VS_TAB_BITS;
 module_param_named(conn_tab_bits, ip_vs_conn_tab_bits, int, 0444);
-MODULE_PARM_DESC(conn_tab_bits, "Set connections' hash size");
+MODULE_PARM_DESC(conn_tab_bits, "Set connections' initial hash size");
 
-/* size and mask values */
+/* current size, the table grows up to 1 << ip_vs_conn_tab_max_bits */
 int ip_vs_conn_tab_size __read_mostly;
-static int ip_vs_conn_tab_mask __read_mostly;
+static int ip_vs_conn_tab_max_bits __read_mostly;
+
+/* grow the table when there are more connections per bucket */
+#define IP_VS_CONN_TAB_LOAD	2
 
 /*
  *  Connection hash table: for input and output packets lookups of IPVS
  */
-static struct hlist_head *ip_vs_conn_tab __read_mostly;
+struct ip_vs_conn_tab {
+	unsigned int		mask;
+	struct hlist_head	heads[];
+};
+
+static struct ip_vs_conn_tab __rcu *ip_vs_conn_tab __read_mostly;
+
+/* previous table, while its entries are moved to ip_vs_conn_tab */
+static struct ip_vs_conn_tab __rcu *ip_vs_conn_tab_old __read_mostly;
+
+/* number of hashed connections, in all netns */
+static struct percpu_counter ip_vs_conn_tab_count;
+
+/* serialize table growth and full table walks */
+static DEFINE_MUTEX(ip_vs_conn_tab_mutex);
+
+static void ip_vs_conn_tab_grow(struct work_struct *work);
+static DECLARE_WORK(ip_vs_conn_tab_work, ip_vs_conn_tab_grow);
 
 /*  SLAB cache for IPVS connections */
 static struct kmem_cache *ip_vs_conn_cachep __read_mostly;
@@ -83,6 +106,8 @@ static unsigned int ip_vs_conn_rnd __read_mostly;
 struct ip_vs_aligned_lock
 {
 	spinlock_t	l;
+	/* bumped while entries move from ip_vs_conn_tab_old */
+	seqcount_spinlock_t seq;
 } __attribute__((__aligned__(SMP_CACHE_BYTES)));
 
 /* lock array for conn table */
@@ -99,10 +124,86 @@ static inline void ct_write_unlock_bh(unsigned int key)
 	spin_unlock_bh(&__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].l);
 }
 
+/* The lock of a bucket is the same in all table sizes, as long as
+ * the table has at least CT_LOCKARRAY_SIZE buckets.
+ */
+static inline seqcount_spinlock_t *ct_seq(unsigned int key)
+{
+	return &__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].seq;
+}
+
+static inline struct hlist_head *
+ip_vs_conn_bucket(struct ip_vs_conn_tab *t, unsigned int hash)
+{
+	return &t->heads[hash & t->mask];
+}
+
+/* Bucket for @hash in the current table, caller holds ct_write_lock(hash) */
+static inline struct hlist_head *ip_vs_conn_bucket_locked(unsigned int hash)
+{
+	struct ip_vs_conn_tab *t;
+
+	t = rcu_dereference_check(ip_vs_conn_tab,
+		lockdep_is_held(&__ip_vs_conntbl_lock_array[hash&CT_LOCKARRAY_MASK].l));
+	return ip_vs_conn_bucket(t, hash);
+}
+
+/* Schedule growth of the table when connections outnumber its buckets */
+static inline void ip_vs_conn_tab_check(void)
+{
+	int size = READ_ONCE(ip_vs_conn_tab_size);
+
+	if (size < (1 << ip_vs_conn_tab_max_bits) &&
+	    percpu_counter_read(&ip_vs_conn_tab_count) >
+	    IP_VS_CONN_TAB_LOAD * size &&
+	    !work_pending(&ip_vs_conn_tab_work))
+		queue_work(system_unbound_wq, &ip_vs_conn_tab_work);
+}
+
+typedef struct ip_vs_conn *(*ip_vs_conn_find_t)(struct hlist_head *head,
+						const struct ip_vs_conn_param *p);
+
+/* Search the bucket for @hash with @find, in the table being migrated
+ * too.  Entries moved to the new table meanwhile are found on retry.
+ * Caller holds rcu_read_lock.
+ */
+static __always_inline struct ip_vs_conn *
+ip_vs_conn_lookup(const struct ip_vs_conn_param *p, unsigned int hash,
+		  ip_vs_conn_find_t find)
+{
+	struct ip_vs_conn_tab *t, *old;
+	struct ip_vs_conn *cp;
+	unsigned int seq;
+
+	do {
+		seq = read_seqcount_begin(ct_seq(hash));
+		t = rcu_dereference(ip_vs_conn_tab);
+		/* pairs with the publication order in ip_vs_conn_tab_grow() */
+		smp_rmb();
+		old = rcu_dereference(ip_vs_conn_tab_old);
+
+		cp = find(ip_vs_conn_bucket(t, hash), p);
+		if (!cp && old)
+			cp = find(ip_vs_conn_bucket(old, hash), p);
+		if (cp)
+			return cp;
+	} while (read_seqcount_retry(ct_seq(hash), seq));
+
+	return NULL;
+}
+
+/* Current table, for walks under ip_vs_conn_tab_mutex */
+static inline struct ip_vs_conn_tab *ip_vs_conn_tab_walk(void)
+{
+	return rcu_dereference_protected(ip_vs_conn_tab,
+				lockdep_is_held(&ip_vs_conn_tab_mutex));
+}
+
 static void ip_vs_conn_expire(struct timer_list *t);
 
 /*
- *	Returns hash value for IPVS connection entry
+ *	Returns hash value for IPVS connection entry, not yet reduced to
+ *	the table size.
  */
 static unsigned int ip_vs_conn_hashkey(struct netns_ipvs *ipvs, int af, unsigned int proto,
 				       const union nf_inet_addr *addr,
@@ -110,13 +211,13 @@ static unsigned int ip_vs_conn_hashkey(struct netns_ipvs *ipvs, int af, unsigned
 {
 #ifdef CONFIG_IP_VS_IPV6
 	if (af == AF_INET6)
-		return (jhash_3words(jhash(addr, 16, ip_vs_conn_rnd),
+		return jhash_3words(jhash(addr, 16, ip_vs_conn_rnd),
 				    (__force u32)port, proto, ip_vs_conn_rnd) ^
-			((size_t)ipvs>>8)) & ip_vs_conn_tab_mask;
+			((size_t)ipvs>>8);
 #endif
-	return (jhash_3words((__force u32)addr->ip, (__force u32)port, proto,
+	return jhash_3words((__force u32)addr->ip, (__force u32)port, proto,
 			    ip_vs_conn_rnd) ^
-		((size_t)ipvs>>8)) & ip_vs_conn_tab_mask;
+		((size_t)ipvs>>8);
 }
 
 static unsigned int ip_vs_conn_hashkey_param(const struct ip_vs_conn_param *p,
@@ -126,8 +227,7 @@ static unsigned int ip_vs_conn_hashkey_param(const struct ip_vs_conn_param *p,
 	__be16 port;
 
 	if (p->pe_data && p->pe->hashkey_raw)
-		return p->pe->hashkey_raw(p, ip_vs_conn_rnd, inverse) &
-			ip_vs_conn_tab_mask;
+		return p->pe->hashkey_raw(p, ip_vs_conn_rnd, inverse);
 
 	if (likely(!inverse)) {
 		addr = p->caddr;
@@ -177,7 +277,7 @@ static inline int ip_vs_conn_hash(struct ip_vs_conn *cp)
 	if (!(cp->flags & IP_VS_CONN_F_HASHED)) {
 		cp->flags |= IP_VS_CONN_F_HASHED;
 		refcount_inc(&cp->refcnt);
-		hlist_add_head_rcu(&cp->c_list, &ip_vs_conn_tab[hash]);
+		hlist_add_head_rcu(&cp->c_list, ip_vs_conn_bucket_locked(hash));
 		ret = 1;
 	} else {
 		pr_err("%s(): request for already hashed, called from %pS\n",
@@ -188,6 +288,11 @@ static inline int ip_vs_conn_hash(struct ip_vs_conn *cp)
 	spin_unlock(&cp->lock);
 	ct_write_unlock_bh(hash);
 
+	if (ret) {
+		percpu_counter_inc(&ip_vs_conn_tab_count);
+		ip_vs_conn_tab_check();
+	}
+
 	return ret;
 }
 
@@ -218,6 +323,9 @@ static inline int ip_vs_conn_unhash(struct ip_vs_conn *cp)
 	spin_unlock(&cp->lock);
 	ct_write_unlock_bh(hash);
 
+	if (ret)
+		percpu_counter_dec(&ip_vs_conn_tab_count);
+
 	return ret;
 }
 
@@ -249,6 +357,9 @@ static inline bool ip_vs_conn_unlink(struct ip_vs_conn *cp)
 	spin_unlock(&cp->lock);
 	ct_write_unlock_bh(hash);
 
+	if (ret)
+		percpu_counter_dec(&ip_vs_conn_tab_count);
+
 	return ret;
 }
 
@@ -259,17 +370,12 @@ static inline bool ip_vs_conn_unlink(struct ip_vs_conn *cp)
  *	p->caddr, p->cport: pkt source address (foreign host)
  *	p->vaddr, p->vport: pkt dest address (load balancer)
  */
-static inline struct ip_vs_conn *
-__ip_vs_conn_in_get(const struct ip_vs_conn_param *p)
+static struct ip_vs_conn *
+ip_vs_conn_in_find(struct hlist_head *head, const struct ip_vs_conn_param *p)
 {
-	unsigned int hash;
 	struct ip_vs_conn *cp;
 
-	hash = ip_vs_conn_hashkey_param(p, false);
-
-	rcu_read_lock();
-
-	hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
+	hlist_for_each_entry_rcu(cp, head, c_list) {
 		if (p->cport == cp->cport && p->vport == cp->vport &&
 		    cp->af == p->af &&
 		    ip_vs_addr_equal(p->af, p->caddr, &cp->caddr) &&
@@ -280,14 +386,26 @@ __ip_vs_conn_in_get(const struct ip_vs_conn_param *p)
 			if (!__ip_vs_conn_get(cp))
 				continue;
 			/* HIT */
-			rcu_read_unlock();
 			return cp;
 		}
 	}
 
+	return NULL;
+}
+
+static inline struct ip_vs_conn *
+__ip_vs_conn_in_get(const struct ip_vs_conn_param *p)
+{
+	unsigned int hash;
+	struct ip_vs_conn *cp;
+
+	hash = ip_vs_conn_hashkey_param(p, false);
+
+	rcu_read_lock();
+	cp = ip_vs_conn_lookup(p, hash, ip_vs_conn_in_find);
 	rcu_read_unlock();
 
-	return NULL;
+	return cp;
 }
 
 struct ip_vs_conn *ip_vs_conn_in_get(const struct ip_vs_conn_param *p)
@@ -345,23 +463,18 @@ ip_vs_conn_in_get_proto(struct netns_ipvs *ipvs, int af,
 }
 EXPORT_SYMBOL_GPL(ip_vs_conn_in_get_proto);
 
-/* Get reference to connection template */
-struct ip_vs_conn *ip_vs_ct_in_get(const struct ip_vs_conn_param *p)
+static struct ip_vs_conn *
+ip_vs_ct_in_find(struct hlist_head *head, const struct ip_vs_conn_param *p)
 {
-	unsigned int hash;
 	struct ip_vs_conn *cp;
 
-	hash = ip_vs_conn_hashkey_param(p, false);
-
-	rcu_read_lock();
-
-	hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
+	hlist_for_each_entry_rcu(cp, head, c_list) {
 		if (unlikely(p->pe_data && p->pe->ct_match)) {
 			if (cp->ipvs != p->ipvs)
 				continue;
 			if (p->pe == cp->pe && p->pe->ct_match(p, cp)) {
 				if (__ip_vs_conn_get(cp))
-					goto out;
+					return cp;
 			}
 			continue;
 		}
@@ -377,12 +490,23 @@ struct ip_vs_conn *ip_vs_ct_in_get(const struct ip_vs_conn_param *p)
 		    p->protocol == cp->protocol &&
 		    cp->ipvs == p->ipvs) {
 			if (__ip_vs_conn_get(cp))
-				goto out;
+				return cp;
 		}
 	}
-	cp = NULL;
 
-  out:
+	return NULL;
+}
+
+/* Get reference to connection template */
+struct ip_vs_conn *ip_vs_ct_in_get(const struct ip_vs_conn_param *p)
+{
+	unsigned int hash;
+	struct ip_vs_conn *cp;
+
+	hash = ip_vs_conn_hashkey_param(p, false);
+
+	rcu_read_lock();
+	cp = ip_vs_conn_lookup(p, hash, ip_vs_ct_in_find);
 	rcu_read_unlock();
 
 	IP_VS_DBG_BUF(9, "template lookup/in %s %s:%d->%s:%d %s\n",
@@ -394,25 +518,14 @@ struct ip_vs_conn *ip_vs_ct_in_get(const struct ip_vs_conn_param *p)
 	return cp;
 }
 
-/* Gets ip_vs_conn associated with supplied parameters in the ip_vs_conn_tab.
- * Called for pkts coming from inside-to-OUTside.
- *	p->caddr, p->cport: pkt source address (inside host)
- *	p->vaddr, p->vport: pkt dest address (foreign host) */
-struct ip_vs_conn *ip_vs_conn_out_get(const struct ip_vs_conn_param *p)
+static struct ip_vs_conn *
+ip_vs_conn_out_find(struct hlist_head *head, const struct ip_vs_conn_param *p)
 {
-	unsigned int hash;
-	struct ip_vs_conn *cp, *ret=NULL;
 	const union nf_inet_addr *saddr;
+	struct ip_vs_conn *cp;
 	__be16 sport;
 
-	/*
-	 *	Check for "full" addressed entries
-	 */
-	hash = ip_vs_conn_hashkey_param(p, true);
-
-	rcu_read_lock();
-
-	hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
+	hlist_for_each_entry_rcu(cp, head, c_list) {
 		if (p->vport != cp->cport)
 			continue;
 
@@ -432,11 +545,29 @@ struct ip_vs_conn *ip_vs_conn_out_get(const struct ip_vs_conn_param *p)
 			if (!__ip_vs_conn_get(cp))
 				continue;
 			/* HIT */
-			ret = cp;
-			break;
+			return cp;
 		}
 	}
 
+	return NULL;
+}
+
+/* Gets ip_vs_conn associated with supplied parameters in the ip_vs_conn_tab.
+ * Called for pkts coming from inside-to-OUTside.
+ *	p->caddr, p->cport: pkt source address (inside host)
+ *	p->vaddr, p->vport: pkt dest address (foreign host) */
+struct ip_vs_conn *ip_vs_conn_out_get(const struct ip_vs_conn_param *p)
+{
+	unsigned int hash;
+	struct ip_vs_conn *ret;
+
+	/*
+	 *	Check for "full" addressed entries
+	 */
+	hash = ip_vs_conn_hashkey_param(p, true);
+
+	rcu_read_lock();
+	ret = ip_vs_conn_lookup(p, hash, ip_vs_conn_out_find);
 	rcu_read_unlock();
 
 	IP_VS_DBG_BUF(9, "lookup/out %s %s:%d->%s:%d %s\n",
@@ -1054,14 +1185,15 @@ static void *ip_vs_conn_array(struct seq_file *seq, loff_t pos)
 	int idx;
 	struct ip_vs_conn *cp;
 	struct ip_vs_iter_state *iter = seq->private;
+	struct ip_vs_conn_tab *t = ip_vs_conn_tab_walk();
 
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++) {
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
+	for (idx = 0; idx <= t->mask; idx++) {
+		hlist_for_each_entry_rcu(cp, &t->heads[idx], c_list) {
 			/* __ip_vs_conn_get() is not needed by
 			 * ip_vs_conn_seq_show and ip_vs_conn_sync_seq_show
 			 */
 			if (pos-- == 0) {
-				iter->l = &ip_vs_conn_tab[idx];
+				iter->l = &t->heads[idx];
 				return cp;
 			}
 		}
@@ -1077,6 +1209,8 @@ static void *ip_vs_conn_seq_start(struct seq_file *seq, loff_t *pos)
 	struct ip_vs_iter_state *iter = seq->private;
 
 	iter->l = NULL;
+	/* keep the table from growing under the walk */
+	mutex_lock(&ip_vs_conn_tab_mutex);
 	rcu_read_lock();
 	return *pos ? ip_vs_conn_array(seq, *pos - 1) :SEQ_START_TOKEN;
 }
@@ -1087,6 +1221,7 @@ static void *ip_vs_conn_seq_next(struct seq_file *seq, void *v, loff_t *pos)
 	struct ip_vs_iter_state *iter = seq->private;
 	struct hlist_node *e;
 	struct hlist_head *l = iter->l;
+	struct ip_vs_conn_tab *t;
 	int idx;
 
 	++*pos;
@@ -1098,10 +1233,11 @@ static void *ip_vs_conn_seq_next(struct seq_file *seq, void *v, loff_t *pos)
 	if (e)
 		return hlist_entry(e, struct ip_vs_conn, c_list);
 
-	idx = l - ip_vs_conn_tab;
-	while (++idx < ip_vs_conn_tab_size) {
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
-			iter->l = &ip_vs_conn_tab[idx];
+	t = ip_vs_conn_tab_walk();
+	idx = l - t->heads;
+	while (++idx <= t->mask) {
+		hlist_for_each_entry_rcu(cp, &t->heads[idx], c_list) {
+			iter->l = &t->heads[idx];
 			return cp;
 		}
 		cond_resched_rcu();
@@ -1114,6 +1250,7 @@ static void ip_vs_conn_seq_stop(struct seq_file *seq, void *v)
 	__releases(RCU)
 {
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 }
 
 static int ip_vs_conn_seq_show(struct seq_file *seq, void *v)
@@ -1302,15 +1439,21 @@ void ip_vs_random_dropentry(struct netns_ipvs *ipvs)
 {
 	int idx;
 	struct ip_vs_conn *cp;
+	struct ip_vs_conn_tab *t;
+
+	/* the table is growing, try again on the next run */
+	if (!mutex_trylock(&ip_vs_conn_tab_mutex))
+		return;
+	t = ip_vs_conn_tab_walk();
 
 	rcu_read_lock();
 	/*
 	 * Randomly scan 1/32 of the whole table every second
 	 */
-	for (idx = 0; idx < (ip_vs_conn_tab_size>>5); idx++) {
-		unsigned int hash = get_random_u32() & ip_vs_conn_tab_mask;
+	for (idx = 0; idx < ((t->mask + 1) >> 5); idx++) {
+		unsigned int hash = get_random_u32() & t->mask;
 
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
+		hlist_for_each_entry_rcu(cp, &t->heads[hash], c_list) {
 			if (cp->ipvs != ipvs)
 				continue;
 			if (atomic_read(&cp->n_control))
@@ -1362,6 +1505,7 @@ drop:
 		cond_resched_rcu();
 	}
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 }
 
 
@@ -1372,12 +1516,15 @@ static void ip_vs_conn_flush(struct netns_ipvs *ipvs)
 {
 	int idx;
 	struct ip_vs_conn *cp, *cp_c;
+	struct ip_vs_conn_tab *t;
 
 flush_again:
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_walk();
 	rcu_read_lock();
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++) {
+	for (idx = 0; idx <= t->mask; idx++) {
 
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
+		hlist_for_each_entry_rcu(cp, &t->heads[idx], c_list) {
 			if (cp->ipvs != ipvs)
 				continue;
 			if (atomic_read(&cp->n_control))
@@ -1393,6 +1540,7 @@ flush_again:
 		cond_resched_rcu();
 	}
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 
 	/* the counter may be not NULL, because maybe some conn entries
 	   are run by slow timer handler or unhashed but still referred */
@@ -1408,10 +1556,13 @@ void ip_vs_expire_nodest_conn_flush(struct netns_ipvs *ipvs)
 	int idx;
 	struct ip_vs_conn *cp, *cp_c;
 	struct ip_vs_dest *dest;
+	struct ip_vs_conn_tab *t;
 
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_walk();
 	rcu_read_lock();
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++) {
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
+	for (idx = 0; idx <= t->mask; idx++) {
+		hlist_for_each_entry_rcu(cp, &t->heads[idx], c_list) {
 			if (cp->ipvs != ipvs)
 				continue;
 
@@ -1437,6 +1588,7 @@ void ip_vs_expire_nodest_conn_flush(struct netns_ipvs *ipvs)
 			break;
 	}
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 }
 #endif
 
@@ -1479,8 +1631,83 @@ void __net_exit ip_vs_conn_net_cleanup(struct netns_ipvs *ipvs)
 #endif
 }
 
+static struct ip_vs_conn_tab *ip_vs_conn_tab_alloc(int bits)
+{
+	struct ip_vs_conn_tab *t;
+	int idx;
+
+	t = kvmalloc(struct_size(t, heads, 1 << bits), GFP_KERNEL);
+	if (!t)
+		return NULL;
+	t->mask = (1 << bits) - 1;
+	for (idx = 0; idx <= t->mask; idx++)
+		INIT_HLIST_HEAD(&t->heads[idx]);
+	return t;
+}
+
+/*
+ * Replace the table with a bigger one.  Lookups keep searching the old
+ * table until it is empty, each bucket is moved under its lock and
+ * seqcount so that readers crossing into the new chain retry.  The lock
+ * of a bucket does not change, the table has at least 1 << 8 buckets.
+ */
+static void ip_vs_conn_tab_grow(struct work_struct *work)
+{
+	struct ip_vs_conn_tab *t, *new;
+	struct hlist_node *n;
+	struct ip_vs_conn *cp;
+	s64 count;
+	int bits, idx;
+
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_walk();
+	count = percpu_counter_sum(&ip_vs_conn_tab_count);
+	bits = ilog2(t->mask + 1);
+	if (bits >= ip_vs_conn_tab_max_bits ||
+	    count <= (s64)IP_VS_CONN_TAB_LOAD * (t->mask + 1))
+		goto out;
+
+	do {
+		bits++;
+	} while (bits < ip_vs_conn_tab_max_bits &&
+		 count > (s64)IP_VS_CONN_TAB_LOAD << bits);
+
+	new = ip_vs_conn_tab_alloc(bits);
+	if (!new)
+		goto out;
+
+	rcu_assign_pointer(ip_vs_conn_tab_old, t);
+	rcu_assign_pointer(ip_vs_conn_tab, new);
+	WRITE_ONCE(ip_vs_conn_tab_size, new->mask + 1);
+
+	for (idx = 0; idx <= t->mask; idx++) {
+		struct ip_vs_aligned_lock *lock;
+
+		lock = &__ip_vs_conntbl_lock_array[idx & CT_LOCKARRAY_MASK];
+		spin_lock_bh(&lock->l);
+		write_seqcount_begin(&lock->seq);
+		hlist_for_each_entry_safe(cp, n, &t->heads[idx], c_list) {
+			hlist_del_rcu(&cp->c_list);
+			hlist_add_head_rcu(&cp->c_list,
+				ip_vs_conn_bucket(new, ip_vs_conn_hashkey_conn(cp)));
+		}
+		write_seqcount_end(&lock->seq);
+		spin_unlock_bh(&lock->l);
+		cond_resched();
+	}
+
+	rcu_assign_pointer(ip_vs_conn_tab_old, NULL);
+	synchronize_rcu();
+	kvfree(t);
+
+	pr_info("Connection hash table grown (size=%d)\n", new->mask + 1);
+out:
+	mutex_unlock(&ip_vs_conn_tab_mutex);
+}
+
 int __init ip_vs_conn_init(void)
 {
+	struct ip_vs_conn_tab *t;
 	size_t tab_array_size;
 	int max_avail;
 #if BITS_PER_LONG > 32
@@ -1497,36 +1724,40 @@ int __init ip_vs_conn_init(void)
 	max_avail -= order_base_2(sizeof(struct ip_vs_conn));
 	max = clamp(max_avail, min, max);
 	ip_vs_conn_tab_bits = clamp(ip_vs_conn_tab_bits, min, max);
+	ip_vs_conn_tab_max_bits = max;
 	ip_vs_conn_tab_size = 1 << ip_vs_conn_tab_bits;
-	ip_vs_conn_tab_mask = ip_vs_conn_tab_size - 1;
 
 	/*
 	 * Allocate the connection hash table and initialize its list heads
 	 */
-	tab_array_size = array_size(ip_vs_conn_tab_size,
-				    sizeof(*ip_vs_conn_tab));
-	ip_vs_conn_tab = kvmalloc_array(ip_vs_conn_tab_size,
-					sizeof(*ip_vs_conn_tab), GFP_KERNEL);
-	if (!ip_vs_conn_tab)
+	tab_array_size = struct_size(t, heads, ip_vs_conn_tab_size);
+	t = ip_vs_conn_tab_alloc(ip_vs_conn_tab_bits);
+	if (!t)
 		return -ENOMEM;
 
+	if (percpu_counter_init(&ip_vs_conn_tab_count, 0, GFP_KERNEL)) {
+		kvfree(t);
+		return -ENOMEM;
+	}
+
 	/* Allocate ip_vs_conn slab cache */
 	ip_vs_conn_cachep = KMEM_CACHE(ip_vs_conn, SLAB_HWCACHE_ALIGN);
 	if (!ip_vs_conn_cachep) {
-		kvfree(ip_vs_conn_tab);
+		percpu_counter_destroy(&ip_vs_conn_tab_count);
+		kvfree(t);
 		return -ENOMEM;
 	}
+	RCU_INIT_POINTER(ip_vs_conn_tab, t);
 
-	pr_info("Connection hash table configured (size=%d, memory=%zdKbytes)\n",
-		ip_vs_conn_tab_size, tab_array_size / 1024);
+	pr_info("Connection hash table configured (size=%d, max=%d, memory=%zdKbytes)\n",
+		ip_vs_conn_tab_size, 1 << max, tab_array_size / 1024);
 	IP_VS_DBG(0, "Each connection entry needs %zd bytes at least\n",
 		  sizeof(struct ip_vs_conn));
 
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++)
-		INIT_HLIST_HEAD(&ip_vs_conn_tab[idx]);
-
 	for (idx = 0; idx < CT_LOCKARRAY_SIZE; idx++)  {
 		spin_lock_init(&__ip_vs_conntbl_lock_array[idx].l);
+		seqcount_spinlock_init(&__ip_vs_conntbl_lock_array[idx].seq,
+				       &__ip_vs_conntbl_lock_array[idx].l);
 	}
 
 	/* calculate the random value for connection hash */
@@ -1537,9 +1768,11 @@ int __init ip_vs_conn_init(void)
 
 void ip_vs_conn_cleanup(void)
 {
+	cancel_work_sync(&ip_vs_conn_tab_work);
 	/* Wait all ip_vs_conn_rcu_free() callbacks to complete */
 	rcu_barrier();
 	/* Release the empty cache */
 	kmem_cache_destroy(ip_vs_conn_cachep);
-	kvfree(ip_vs_conn_tab);
+	percpu_counter_destroy(&ip_vs_conn_tab_count);
+	kvfree(rcu_dereference_protected(ip_vs_conn_tab, 1));
 }
@@ -69,6 +69,7 @@ struct conntrack_gc_work {
 	u32			avg_timeout;
 	u32			count;
 	u32			start_time;
+	unsigned long		wheel_tick;
 	bool			exiting;
 	bool			early_drop;
 };
@@ -101,6 +102,98 @@ static DEFINE_MUTEX(nf_conntrack_mutex);
 
 static struct conntrack_gc_work conntrack_gc_work;
 
+/* Coarse per-cpu expiry wheel.  Confirmed conntracks are filed under the
+ * slot their timeout falls into so that gc_worker only has to look at the
+ * entries that are due instead of walking the whole table.
+ *
+ * Timeout extensions don't move an entry, it is visited early and filed
+ * again.  Timeouts beyond the wheel horizon are filed in the last slot.
+ */
+#define NF_CT_WHEEL_BITS	8
+#define NF_CT_WHEEL_SLOTS	(1u << NF_CT_WHEEL_BITS)
+#define NF_CT_WHEEL_MASK	(NF_CT_WHEEL_SLOTS - 1)
+#define NF_CT_WHEEL_GRAN	(1ul * HZ)
+
+struct nf_ct_wheel {
+	spinlock_t		lock;
+	unsigned int		count;
+	struct hlist_head	slots[NF_CT_WHEEL_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct nf_ct_wheel, nf_ct_wheel);
+
+/* must hold wheel->lock */
+static void nf_ct_wheel_file(struct nf_ct_wheel *wheel, struct nf_conn *ct)
+{
+	long delta = (s32)(READ_ONCE(ct->timeout) - nfct_time_stamp);
+	unsigned long tick = jiffies / NF_CT_WHEEL_GRAN;
+
+	delta = clamp_t(long, delta / (long)NF_CT_WHEEL_GRAN,
+			0, NF_CT_WHEEL_SLOTS - 1);
+	hlist_add_head(&ct->expiry_node,
+		       &wheel->slots[(tick + delta) & NF_CT_WHEEL_MASK]);
+	wheel->count++;
+}
+
+/* must be called with bh disabled */
+static void nf_ct_wheel_add(struct nf_conn *ct)
+{
+	struct nf_ct_wheel *wheel = this_cpu_ptr(&nf_ct_wheel);
+
+	spin_lock(&wheel->lock);
+	ct->expiry_cpu = smp_processor_id();
+	nf_ct_wheel_file(wheel, ct);
+	spin_unlock(&wheel->lock);
+}
+
+/* must be called with bh disabled */
+static void nf_ct_wheel_del(struct nf_conn *ct)
+{
+	struct nf_ct_wheel *wheel = per_cpu_ptr(&nf_ct_wheel, ct->expiry_cpu);
+
+	spin_lock(&wheel->lock);
+	if (!hlist_unhashed(&ct->expiry_node)) {
+		hlist_del_init(&ct->expiry_node);
+		wheel->count--;
+	}
+	spin_unlock(&wheel->lock);
+}
+
+/* Timeout was reduced to @timeout, move the entry to an earlier slot. */
+static void nf_ct_wheel_refile(struct nf_conn *ct, u32 old, u32 timeout)
+{
+	struct nf_ct_wheel *wheel;
+	s32 delta = old - timeout;
+
+	if (delta < (s32)NF_CT_WHEEL_GRAN ||
+	    (s32)(timeout - nfct_time_stamp) >=
+	    (s32)(NF_CT_WHEEL_SLOTS * NF_CT_WHEEL_GRAN))
+		return;
+
+	wheel = per_cpu_ptr(&nf_ct_wheel, ct->expiry_cpu);
+
+	spin_lock_bh(&wheel->lock);
+	if (!hlist_unhashed(&ct->expiry_node)) {
+		hlist_del(&ct->expiry_node);
+		wheel->count--;
+		nf_ct_wheel_file(wheel, ct);
+	}
+	spin_unlock_bh(&wheel->lock);
+}
+
+/* Set the timeout of @ct to @timeout, in nfct_time_stamp units, and move
+ * a confirmed entry to an earlier slot of the expiry wheel if needed.
+ */
+void nf_ct_set_expiry(struct nf_conn *ct, u32 timeout)
+{
+	u32 old = READ_ONCE(ct->timeout);
+
+	WRITE_ONCE(ct->timeout, timeout);
+	if (nf_ct_is_confirmed(ct) && (s32)(timeout - old) < 0)
+		nf_ct_wheel_refile(ct, old, timeout);
+}
+EXPORT_SYMBOL_GPL(nf_ct_set_expiry);
+
 void nf_conntrack_lock(spinlock_t *lock) __acquires(lock)
 {
 	/* 1) Acquire the lock */
@@ -617,6 +710,8 @@ static void __nf_ct_delete_from_lists(struct nf_conn *ct)
 
 	clean_from_lists(ct);
 	nf_conntrack_double_unlock(hash, reply_hash);
+
+	nf_ct_wheel_del(ct);
 }
 
 static void nf_ct_delete_from_lists(struct nf_conn *ct)
@@ -834,6 +929,7 @@ static void __nf_conntrack_hash_insert(struct nf_conn *ct,
 			   &nf_conntrack_hash[hash]);
 	hlist_nulls_add_head_rcu(&ct->tuplehash[IP_CT_DIR_REPLY].hnnode,
 			   &nf_conntrack_hash[reply_hash]);
+	nf_ct_wheel_add(ct);
 }
 
 static bool nf_ct_ext_valid_pre(const struct nf_ct_ext *ext)
@@ -1121,6 +1217,7 @@ static int nf_ct_resolve_clash_harder(struct sk_buff *skb, u32 repl_idx)
 
 	hlist_nulls_add_head_rcu(&loser_ct->tuplehash[IP_CT_DIR_REPLY].hnnode,
 				 &nf_conntrack_hash[repl_idx]);
+	nf_ct_wheel_add(loser_ct);
 	/* confirmed bit must be set after hlist add, not before:
 	 * loser_ct can still be visible to other cpu due to
 	 * SLAB_TYPESAFE_BY_RCU.
@@ -1510,18 +1607,98 @@ static bool gc_worker_can_early_drop(const struct nf_conn *ct)
 	return false;
 }
 
-static void gc_worker(struct work_struct *work)
+/* Visit the entries filed under @slot, reap the expired ones and file
+ * the others again.
+ */
+static void gc_wheel_slot(struct nf_ct_wheel *wheel, unsigned int slot)
+{
+	struct hlist_head todo;
+	struct nf_conn *ct;
+
+	spin_lock_bh(&wheel->lock);
+	hlist_move_list(&wheel->slots[slot], &todo);
+
+	while (!hlist_empty(&todo)) {
+		bool reaped = false;
+		struct net *net;
+
+		ct = hlist_entry(todo.first, struct nf_conn, expiry_node);
+		hlist_del_init(&ct->expiry_node);
+		wheel->count--;
+
+		if (!refcount_inc_not_zero(&ct->ct_general.use))
+			continue;
+		spin_unlock_bh(&wheel->lock);
+
+		/* load ->status after refcount increase */
+		smp_acquire__after_ctrl_dep();
+
+		net = nf_ct_net(ct);
+		NF_CT_STAT_INC_ATOMIC(net, gc_scanned);
+
+		if (test_bit(IPS_OFFLOAD_BIT, &ct->status))
+			nf_ct_offload_timeout(ct);
+
+		if (nf_ct_should_gc(ct)) {
+			nf_ct_kill(ct);
+			NF_CT_STAT_INC_ATOMIC(net, gc_reaped);
+			reaped = true;
+		}
+
+		/* a concurrent nf_ct_delete() sets IPS_DYING before it
+		 * takes the wheel lock to unlink the entry.
+		 */
+		spin_lock_bh(&wheel->lock);
+		if (!reaped && !nf_ct_is_dying(ct) &&
+		    hlist_unhashed(&ct->expiry_node))
+			nf_ct_wheel_file(wheel, ct);
+		spin_unlock_bh(&wheel->lock);
+
+		nf_ct_put(ct);
+		cond_resched();
+		spin_lock_bh(&wheel->lock);
+	}
+
+	spin_unlock_bh(&wheel->lock);
+}
+
+static unsigned long gc_scan_wheel(struct conntrack_gc_work *gc_work)
+{
+	unsigned long now = jiffies / NF_CT_WHEEL_GRAN;
+	unsigned long ticks, tick;
+	unsigned int count = 0;
+	int cpu;
+
+	/* slot of the current tick is still filling up, stop before it */
+	ticks = min_t(unsigned long, now - gc_work->wheel_tick,
+		      NF_CT_WHEEL_SLOTS);
+
+	for_each_possible_cpu(cpu) {
+		struct nf_ct_wheel *wheel = per_cpu_ptr(&nf_ct_wheel, cpu);
+
+		for (tick = now - ticks; tick != now; tick++)
+			gc_wheel_slot(wheel, tick & NF_CT_WHEEL_MASK);
+
+		count += READ_ONCE(wheel->count);
+	}
+
+	gc_work->wheel_tick = now;
+
+	if (!count)
+		return GC_SCAN_INTERVAL_MAX;
+
+	return NF_CT_WHEEL_GRAN - jiffies % NF_CT_WHEEL_GRAN;
+}
+
+static unsigned long gc_scan_table(struct conntrack_gc_work *gc_work)
 {
 	unsigned int i, hashsz, nf_conntrack_max95 = 0;
 	u32 end_time, start_time = nfct_time_stamp;
-	struct conntrack_gc_work *gc_work;
 	unsigned int expired_count = 0;
 	unsigned long next_run;
 	s32 delta_time;
 	long count;
 
-	gc_work = container_of(work, struct conntrack_gc_work, dwork.work);
-
 	i = gc_work->next_bucket;
 	if (gc_work->early_drop)
 		nf_conntrack_max95 = nf_conntrack_max / 100u * 95u;
@@ -1557,6 +1734,7 @@ static void gc_worker(struct work_struct *work)
 			long expires;
 
 			tmp = nf_ct_tuplehash_to_ctrack(h);
+			NF_CT_STAT_INC_ATOMIC(nf_ct_net(tmp), gc_scanned);
 
 			if (test_bit(IPS_OFFLOAD_BIT, &tmp->status)) {
 				nf_ct_offload_timeout(tmp);
@@ -1574,12 +1752,12 @@ static void gc_worker(struct work_struct *work)
 				delta_time = nfct_time_stamp - gc_work->start_time;
 
 				/* re-sched immediately if total cycle time is exceeded */
-				next_run = delta_time < (s32)GC_SCAN_INTERVAL_MAX;
-				goto early_exit;
+				return delta_time < (s32)GC_SCAN_INTERVAL_MAX;
 			}
 
 			if (nf_ct_is_expired(tmp)) {
 				nf_ct_gc_expired(tmp);
+				NF_CT_STAT_INC_ATOMIC(nf_ct_net(tmp), gc_reaped);
 				expired_count++;
 				continue;
 			}
@@ -1629,8 +1807,7 @@ static void gc_worker(struct work_struct *work)
 			gc_work->avg_timeout = next_run;
 			gc_work->count = count;
 			gc_work->next_bucket = i;
-			next_run = 0;
-			goto early_exit;
+			return 0;
 		}
 	} while (i < hashsz);
 
@@ -1644,7 +1821,24 @@ static void gc_worker(struct work_struct *work)
 	else
 		next_run = 1;
 
-early_exit:
+	return next_run;
+}
+
+static void gc_worker(struct work_struct *work)
+{
+	struct conntrack_gc_work *gc_work;
+	unsigned long next_run;
+
+	gc_work = container_of(work, struct conntrack_gc_work, dwork.work);
+
+	/* The expiry wheel only finds timed out entries.  Walk the table
+	 * when it is full, to also early-drop entries that are not assured.
+	 */
+	if (gc_work->early_drop || gc_work->next_bucket)
+		next_run = gc_scan_table(gc_work);
+	else
+		next_run = gc_scan_wheel(gc_work);
+
 	if (gc_work->exiting)
 		return;
 
@@ -1657,6 +1851,7 @@ early_exit:
 static void conntrack_gc_work_init(struct conntrack_gc_work *gc_work)
 {
 	INIT_DELAYED_WORK(&gc_work->dwork, gc_worker);
+	gc_work->wheel_tick = jiffies / NF_CT_WHEEL_GRAN;
 	gc_work->exiting = false;
 }
 
@@ -2112,11 +2307,15 @@ void __nf_ct_refresh_acct(struct nf_conn *ct,
 		goto acct;
 
 	/* If not in hash table, timer will not be active yet */
-	if (nf_ct_is_confirmed(ct))
-		extra_jiffies += nfct_time_stamp;
+	if (!nf_ct_is_confirmed(ct)) {
+		if (READ_ONCE(ct->timeout) != extra_jiffies)
+			WRITE_ONCE(ct->timeout, extra_jiffies);
+		goto acct;
+	}
 
+	extra_jiffies += nfct_time_stamp;
 	if (READ_ONCE(ct->timeout) != extra_jiffies)
-		WRITE_ONCE(ct->timeout, extra_jiffies);
+		nf_ct_set_expiry(ct, extra_jiffies);
 acct:
 	if (do_acct)
 		nf_ct_acct_update(ct, CTINFO2DIR(ctinfo), skb->len);
@@ -2646,6 +2845,9 @@ int nf_conntrack_init_start(void)
 	for (i = 0; i < CONNTRACK_LOCKS; i++)
 		spin_lock_init(&nf_conntrack_locks[i]);
 
+	for_each_possible_cpu(i)
+		spin_lock_init(&per_cpu_ptr(&nf_ct_wheel, i)->lock);
+
 	if (!nf_conntrack_htable_size) {
 		nf_conntrack_htable_size
 			= (((nr_pages << PAGE_SHIFT) / 16384)
@@ -768,7 +768,7 @@ static void __cold nf_tcp_handle_invalid(struct nf_conn *ct,
 					  "packet (index %d, dir %d) response for index %d lower timeout to %u",
 					  index, dir, ct->proto.tcp.last_index, timeout);
 
-			WRITE_ONCE(ct->timeout, timeout + nfct_time_stamp);
+			nf_ct_set_expiry(ct, timeout + nfct_time_stamp);
 		}
 	} else {
 		ct->proto.tcp.last_index = index;
@@ -942,7 +942,7 @@ void nf_conntrack_tcp_set_closing(struct nf_conn *ct)
 	}
 
 	timeout = timeouts[TCP_CONNTRACK_CLOSE];
-	WRITE_ONCE(ct->timeout, timeout + nfct_time_stamp);
+	nf_ct_set_expiry(ct, timeout + nfct_time_stamp);
 
 	spin_unlock_bh(&ct->lock);
 
@@ -196,7 +196,7 @@ static void flow_offload_fixup_ct(struct nf_conn *ct)
 		timeout = 0;
 
 	if (nf_flow_timeout_delta(READ_ONCE(ct->timeout)) > (__s32)timeout)
-		WRITE_ONCE(ct->timeout, nfct_time_stamp + timeout);
+		nf_ct_set_expiry(ct, nfct_time_stamp + timeout);
 }
 
 static void flow_offload_route_release(struct flow_offload *flow)
@@ -9848,6 +9848,97 @@ static bool nft_expr_reduce(struct nft_regs_track *track,
 	return false;
 }
 
+static bool nft_payload_cmp_fast_fusable(const struct nft_expr *expr,
+					 const struct nft_expr *last)
+{
+	const struct nft_cmp_fast_expr *cmp;
+	const struct nft_payload *payload;
+	const struct nft_expr *next;
+
+	if (expr->ops != &nft_payload_fast_ops)
+		return false;
+
+	next = nft_expr_next(expr);
+	if (next == last || next->ops != &nft_cmp_fast_ops)
+		return false;
+
+	payload = nft_expr_priv(expr);
+	cmp = nft_expr_priv(next);
+
+	return cmp->sreg == payload->dreg;
+}
+
+static void nft_payload_cmp_fast_fuse(void *data, const struct nft_expr *expr)
+{
+	struct nft_payload_cmp_fast_expr *priv;
+	struct nft_expr *fused = data;
+
+	fused->ops = &nft_payload_cmp_fast_ops;
+	priv = nft_expr_priv(fused);
+	priv->payload = *(const struct nft_payload *)nft_expr_priv(expr);
+	priv->cmp = *(const struct nft_cmp_fast_expr *)nft_expr_priv(nft_expr_next(expr));
+	priv->skip = 0;
+}
+
+static struct nft_payload_cmp_fast_expr *
+nft_rule_dp_leading_match(const struct nft_rule_dp *rule)
+{
+	struct nft_expr *expr = (struct nft_expr *)&rule->data[0];
+
+	if (rule->is_last || !rule->dlen ||
+	    expr->ops != &nft_payload_cmp_fast_ops)
+		return NULL;
+
+	return nft_expr_priv(expr);
+}
+
+static bool nft_leading_match_equal(const struct nft_payload_cmp_fast_expr *a,
+				    const struct nft_payload_cmp_fast_expr *b)
+{
+	return a->payload.base == b->payload.base &&
+	       a->payload.offset == b->payload.offset &&
+	       a->payload.len == b->payload.len &&
+	       a->payload.dreg == b->payload.dreg &&
+	       a->cmp.data == b->cmp.data &&
+	       a->cmp.mask == b->cmp.mask &&
+	       a->cmp.sreg == b->cmp.sreg &&
+	       a->cmp.len == b->cmp.len &&
+	       a->cmp.inv == b->cmp.inv;
+}
+
+/* Runs of rules starting with the same fused payload+cmp match are linked
+ * so that, once the match fails, nft_do_chain() resumes after the run
+ * instead of evaluating the same match again for every rule in it.
+ */
+static void nft_rule_blob_link_matches(struct nft_rule_blob *blob)
+{
+	struct nft_payload_cmp_fast_expr *head, *priv;
+	const struct nft_rule_dp *rule, *last, *next;
+
+	rule = (const struct nft_rule_dp *)blob->data;
+	while (!rule->is_last) {
+		next = nft_rule_next(rule);
+		head = nft_rule_dp_leading_match(rule);
+		if (!head) {
+			rule = next;
+			continue;
+		}
+
+		last = rule;
+		while ((priv = nft_rule_dp_leading_match(next)) &&
+		       nft_leading_match_equal(head, priv)) {
+			last = next;
+			next = nft_rule_next(next);
+		}
+
+		for (; rule != last; rule = nft_rule_next(rule)) {
+			priv = nft_rule_dp_leading_match(rule);
+			priv->skip = (const void *)last - (const void *)rule;
+		}
+		rule = next;
+	}
+}
+
 static int nf_tables_commit_chain_prepare(struct net *net, struct nft_chain *chain)
 {
 	const struct nft_expr *expr, *last;
@@ -9897,6 +9988,16 @@ static int nf_tables_commit_chain_prepare(struct net *net, struct nft_chain *cha
 				continue;
 			}
 
+			if (!size && nft_payload_cmp_fast_fusable(expr, last)) {
+				if (WARN_ON_ONCE(data + nft_payload_cmp_fast_ops.size > data_boundary))
+					return -ENOMEM;
+
+				nft_payload_cmp_fast_fuse(data, expr);
+				size = nft_payload_cmp_fast_ops.size;
+				expr = nft_expr_next(expr);
+				continue;
+			}
+
 			if (WARN_ON_ONCE(data + size + expr->ops->size > data_boundary))
 				return -ENOMEM;
 
@@ -9921,6 +10022,8 @@ static int nf_tables_commit_chain_prepare(struct net *net, struct nft_chain *cha
 	prule = (struct nft_rule_dp *)data;
 	nft_last_rule(chain, prule);
 
+	nft_rule_blob_link_matches(chain->blob_next);
+
 	return 0;
 }
 
@@ -84,16 +84,20 @@ static void nft_bitwise_fast_eval(const struct nft_expr *expr,
 	*dst = (*src & priv->mask) ^ priv->xor;
 }
 
-static void nft_cmp_fast_eval(const struct nft_expr *expr,
-			      struct nft_regs *regs)
+static void __nft_cmp_fast_eval(const struct nft_cmp_fast_expr *priv,
+				struct nft_regs *regs)
 {
-	const struct nft_cmp_fast_expr *priv = nft_expr_priv(expr);
-
 	if (((regs->data[priv->sreg] & priv->mask) == priv->data) ^ priv->inv)
 		return;
 	regs->verdict.code = NFT_BREAK;
 }
 
+static void nft_cmp_fast_eval(const struct nft_expr *expr,
+			      struct nft_regs *regs)
+{
+	__nft_cmp_fast_eval(nft_expr_priv(expr), regs);
+}
+
 static void nft_cmp16_fast_eval(const struct nft_expr *expr,
 				struct nft_regs *regs)
 {
@@ -144,11 +148,10 @@ static inline void nft_trace_verdict(const struct nft_pktinfo *pkt,
 		__nft_trace_verdict(pkt, info, rule, regs);
 }
 
-static bool nft_payload_fast_eval(const struct nft_expr *expr,
-				  struct nft_regs *regs,
-				  const struct nft_pktinfo *pkt)
+static bool __nft_payload_fast_eval(const struct nft_payload *priv,
+				    struct nft_regs *regs,
+				    const struct nft_pktinfo *pkt)
 {
-	const struct nft_payload *priv = nft_expr_priv(expr);
 	const struct sk_buff *skb = pkt->skb;
 	u32 *dest = &regs->data[priv->dreg];
 	unsigned char *ptr;
@@ -176,6 +179,47 @@ static bool nft_payload_fast_eval(const struct nft_expr *expr,
 	return true;
 }
 
+static bool nft_payload_fast_eval(const struct nft_expr *expr,
+				  struct nft_regs *regs,
+				  const struct nft_pktinfo *pkt)
+{
+	return __nft_payload_fast_eval(nft_expr_priv(expr), regs, pkt);
+}
+
+static void nft_payload_cmp_fast_eval(const struct nft_expr *expr,
+				      struct nft_regs *regs,
+				      const struct nft_pktinfo *pkt)
+{
+	const struct nft_payload_cmp_fast_expr *priv = nft_expr_priv(expr);
+
+	if (!__nft_payload_fast_eval(&priv->payload, regs, pkt)) {
+		/* priv->payload is the first member, nft_payload_eval()
+		 * sees a plain payload expression.
+		 */
+		nft_payload_eval(expr, regs, pkt);
+		if (regs->verdict.code != NFT_CONTINUE)
+			return;
+	}
+
+	__nft_cmp_fast_eval(&priv->cmp, regs);
+}
+
+/* Only used in the rule blob, see nf_tables_commit_chain_prepare(). */
+const struct nft_expr_ops nft_payload_cmp_fast_ops = {
+	.type		= &nft_payload_type,
+	.size		= NFT_EXPR_SIZE(sizeof(struct nft_payload_cmp_fast_expr)),
+};
+
+/* Rules following this one that start with the very same match fail too. */
+static const struct nft_rule_dp *
+nft_payload_cmp_fast_skip(const struct nft_rule_dp *rule,
+			  const struct nft_expr *expr)
+{
+	const struct nft_payload_cmp_fast_expr *priv = nft_expr_priv(expr);
+
+	return (const void *)rule + priv->skip;
+}
+
 DEFINE_STATIC_KEY_FALSE(nft_counters_enabled);
 
 static noinline void nft_update_chain_stats(const struct nft_chain *chain,
@@ -277,7 +321,9 @@ next_rule:
 	regs.verdict.code = NFT_CONTINUE;
 	for (; !rule->is_last ; rule = nft_rule_next(rule)) {
 		nft_rule_dp_for_each_expr(expr, last, rule) {
-			if (expr->ops == &nft_cmp_fast_ops)
+			if (expr->ops == &nft_payload_cmp_fast_ops)
+				nft_payload_cmp_fast_eval(expr, &regs, pkt);
+			else if (expr->ops == &nft_cmp_fast_ops)
 				nft_cmp_fast_eval(expr, &regs);
 			else if (expr->ops == &nft_cmp16_fast_ops)
 				nft_cmp16_fast_eval(expr, &regs);
@@ -295,6 +341,8 @@ next_rule:
 		case NFT_BREAK:
 			regs.verdict.code = NFT_CONTINUE;
 			nft_trace_copy_nftrace(pkt, &info);
+			if (expr->ops == &nft_payload_cmp_fast_ops)
+				rule = nft_payload_cmp_fast_skip(rule, expr);
 			continue;
 		case NFT_CONTINUE:
 			nft_trace_packet(pkt, &regs.verdict,  &info, rule,
@@ -180,10 +180,13 @@ struct sw_flow_key_range {
 	unsigned short int end;
 };
 
+struct flow_mask_stages;
+
 struct sw_flow_mask {
 	int ref_count;
 	struct rcu_head rcu;
 	struct sw_flow_key_range range;
+	struct flow_mask_stages *stages; /* Only for masks in a flow table. */
 	struct sw_flow_key key;
 };
 
@@ -50,23 +50,47 @@ static u16 range_n_bytes(const struct sw_flow_key_range *range)
 	return range->end - range->start;
 }
 
+/* Stage boundaries of the flow key in key order: metadata, L2, the IP
+ * protocol fields and L4 ports, the L3 addresses and conntrack tuple.
+ */
+static const unsigned short flow_stage_bounds[FLOW_MASK_STAGES - 1] = {
+	ALIGN_DOWN(offsetof(struct sw_flow_key, eth), sizeof(long)),
+	ALIGN_DOWN(offsetof(struct sw_flow_key, ip), sizeof(long)),
+	ALIGN_DOWN(offsetof(struct sw_flow_key, ipv4), sizeof(long)),
+};
+
+/* Order in which the stages above are hashed, see struct flow_mask_stages. */
+static const u8 flow_stage_order[FLOW_MASK_STAGES] = { 0, 1, 3, 2 };
+
+static void flow_mask_key_range(struct sw_flow_key *dst,
+				const struct sw_flow_key *src,
+				const struct sw_flow_mask *mask,
+				const struct sw_flow_key_range *range)
+{
+	const long *m = (const long *)((const u8 *)&mask->key + range->start);
+	const long *s = (const long *)((const u8 *)src + range->start);
+	long *d = (long *)((u8 *)dst + range->start);
+	int i;
+
+	for (i = range->start; i < range->end; i += sizeof(long))
+		*d++ = *s++ & *m++;
+}
+
 void ovs_flow_mask_key(struct sw_flow_key *dst, const struct sw_flow_key *src,
 		       bool full, const struct sw_flow_mask *mask)
 {
-	int start = full ? 0 : mask->range.start;
-	int len = full ? sizeof *dst : range_n_bytes(&mask->range);
-	const long *m = (const long *)((const u8 *)&mask->key + start);
-	const long *s = (const long *)((const u8 *)src + start);
-	long *d = (long *)((u8 *)dst + start);
-	int i;
+	struct sw_flow_key_range range = mask->range;
 
 	/* If 'full' is true then all of 'dst' is fully initialized. Otherwise,
 	 * if 'full' is false the memory outside of the 'mask->range' is left
 	 * uninitialized. This can be used as an optimization when further
 	 * operations on 'dst' only use contents within 'mask->range'.
 	 */
-	for (i = 0; i < len; i += sizeof(long))
-		*d++ = *s++ & *m++;
+	if (full) {
+		range.start = 0;
+		range.end = sizeof(*dst);
+	}
+	flow_mask_key_range(dst, src, mask, &range);
 }
 
 struct sw_flow *ovs_flow_alloc(void)
@@ -456,6 +480,42 @@ static void flow_tbl_destroy_rcu_cb(struct rcu_head *rcu)
 	__table_instance_destroy(ti);
 }
 
+static u32 flow_hash_stage(const struct sw_flow_key *key,
+			   const struct sw_flow_key_range *range, u32 hash)
+{
+	const u32 *hash_key = (const u32 *)((const u8 *)key + range->start);
+
+	/* Make sure number of hash bytes are multiple of u32. */
+	int hash_u32s = range_n_bytes(range) >> 2;
+
+	return jhash2(hash_key, hash_u32s, hash);
+}
+
+static u16 *flow_stage_filter(struct flow_mask_stages *st, int stage, u32 hash)
+{
+	return &st->filter[stage][hash & (FLOW_STAGE_FILTER_SIZE - 1)];
+}
+
+/* Account 'flow' in the stage filters of its mask.  Saturated counters
+ * are left alone, they only cost the early termination.
+ * Must be called with OVS mutex held.
+ */
+static void flow_mask_stages_update(const struct sw_flow *flow, int delta)
+{
+	struct flow_mask_stages *st = flow->mask->stages;
+	u32 hash = 0;
+	int i;
+
+	for (i = 0; i < st->n_stages - 1; i++) {
+		u16 *cnt;
+
+		hash = flow_hash_stage(&flow->key, &st->range[i], hash);
+		cnt = flow_stage_filter(st, i, hash);
+		if (*cnt != U16_MAX)
+			WRITE_ONCE(*cnt, *cnt + delta);
+	}
+}
+
 static void table_instance_flow_free(struct flow_table *table,
 				     struct table_instance *ti,
 				     struct table_instance *ufid_ti,
@@ -463,6 +523,7 @@ static void table_instance_flow_free(struct flow_table *table,
 {
 	hlist_del_rcu(&flow->flow_table.node[ti->node_ver]);
 	table->count--;
+	flow_mask_stages_update(flow, -1);
 
 	if (ovs_identifier_is_ufid(&flow->id)) {
 		hlist_del_rcu(&flow->ufid_table.node[ufid_ti->node_ver]);
@@ -642,15 +703,18 @@ err_free_ti:
 	return -ENOMEM;
 }
 
+/* Hash of a masked key, chained over the stages of the mask. */
 static u32 flow_hash(const struct sw_flow_key *key,
-		     const struct sw_flow_key_range *range)
+		     const struct sw_flow_mask *mask)
 {
-	const u32 *hash_key = (const u32 *)((const u8 *)key + range->start);
+	const struct flow_mask_stages *st = mask->stages;
+	u32 hash = 0;
+	int i;
 
-	/* Make sure number of hash bytes are multiple of u32. */
-	int hash_u32s = range_n_bytes(range) >> 2;
+	for (i = 0; i < st->n_stages; i++)
+		hash = flow_hash_stage(key, &st->range[i], hash);
 
-	return jhash2(hash_key, hash_u32s, 0);
+	return hash;
 }
 
 static int flow_key_start(const struct sw_flow_key *key)
@@ -700,16 +764,28 @@ static struct sw_flow *masked_flow_lookup(struct table_instance *ti,
 					  const struct sw_flow_mask *mask,
 					  u32 *n_mask_hit)
 {
+	struct flow_mask_stages *st = mask->stages;
 	struct sw_flow *flow;
 	struct hlist_head *head;
-	u32 hash;
+	u32 hash = 0;
 	struct sw_flow_key masked_key;
+	int i;
 
-	ovs_flow_mask_key(&masked_key, unmasked, false, mask);
-	hash = flow_hash(&masked_key, &mask->range);
-	head = find_bucket(ti, hash);
 	(*n_mask_hit)++;
 
+	/* Mask and hash the key one stage at a time, no flow of this mask
+	 * can match once a partial hash is missing from its stage filter.
+	 */
+	for (i = 0; i < st->n_stages; i++) {
+		flow_mask_key_range(&masked_key, unmasked, mask, &st->range[i]);
+		hash = flow_hash_stage(&masked_key, &st->range[i], hash);
+		if (i < st->n_stages - 1 &&
+		    !READ_ONCE(*flow_stage_filter(st, i, hash)))
+			return NULL;
+	}
+
+	head = find_bucket(ti, hash);
+
 	hlist_for_each_entry_rcu(flow, head, flow_table.node[ti->node_ver],
 				 lockdep_ovsl_is_held()) {
 		if (flow->mask == mask && flow->flow_table.hash == hash &&
@@ -962,17 +1038,49 @@ void ovs_flow_tbl_remove(struct flow_table *table, struct sw_flow *flow)
 	table_instance_flow_free(table, ti, ufid_ti, flow);
 }
 
+/* The stages of a mask are allocated with it, freed by kfree_rcu(). */
 static struct sw_flow_mask *mask_alloc(void)
 {
 	struct sw_flow_mask *mask;
 
-	mask = kmalloc(sizeof(*mask), GFP_KERNEL);
-	if (mask)
+	mask = kmalloc(sizeof(*mask) + sizeof(struct flow_mask_stages),
+		       GFP_KERNEL);
+	if (mask) {
 		mask->ref_count = 1;
+		mask->stages = (struct flow_mask_stages *)(mask + 1);
+	}
 
 	return mask;
 }
 
+/* Split the range of 'mask' into the stages it spans, in hash order. */
+static void mask_stages_init(struct sw_flow_mask *mask)
+{
+	struct flow_mask_stages *st = mask->stages;
+	int i;
+
+	memset(st, 0, sizeof(*st));
+	for (i = 0; i < FLOW_MASK_STAGES; i++) {
+		int seg = flow_stage_order[i];
+		unsigned short start = mask->range.start;
+		unsigned short end = mask->range.end;
+
+		if (seg > 0)
+			start = max(start, flow_stage_bounds[seg - 1]);
+		if (seg < FLOW_MASK_STAGES - 1)
+			end = min(end, flow_stage_bounds[seg]);
+		if (start >= end)
+			continue;
+		st->range[st->n_stages].start = start;
+		st->range[st->n_stages].end = end;
+		st->n_stages++;
+	}
+	if (!st->n_stages) {
+		st->range[0] = mask->range;
+		st->n_stages = 1;
+	}
+}
+
 static bool mask_equal(const struct sw_flow_mask *a,
 		       const struct sw_flow_mask *b)
 {
@@ -1016,6 +1124,7 @@ static int flow_mask_insert(struct flow_table *tbl, struct sw_flow *flow,
 			return -ENOMEM;
 		mask->key = new->key;
 		mask->range = new->range;
+		mask_stages_init(mask);
 
 		/* Add mask to mask-list. */
 		if (tbl_mask_array_add_mask(tbl, mask)) {
@@ -1037,7 +1146,8 @@ static void flow_key_insert(struct flow_table *table, struct sw_flow *flow)
 	struct table_instance *new_ti = NULL;
 	struct table_instance *ti;
 
-	flow->flow_table.hash = flow_hash(&flow->key, &flow->mask->range);
+	flow->flow_table.hash = flow_hash(&flow->key, flow->mask);
+	flow_mask_stages_update(flow, 1);
 	ti = ovsl_dereference(table->ti);
 	table_instance_insert(ti, flow);
 	table->count++;
@@ -33,6 +33,21 @@ struct mask_cache {
 	struct mask_cache_entry __percpu *mask_cache;
 };
 
+#define FLOW_MASK_STAGES	4
+#define FLOW_STAGE_FILTER_SIZE	256  /* Must be ^2 value. */
+
+/* Staged lookup: the masked key is hashed one stage at a time (metadata,
+ * L2, L3 addresses, IP protocol fields and L4 ports) and a lookup with
+ * the mask ends early after a stage whose partial hash no flow of the
+ * mask has.  'filter' counts the flows per partial hash of every stage
+ * but the last one.
+ */
+struct flow_mask_stages {
+	int n_stages;
+	struct sw_flow_key_range range[FLOW_MASK_STAGES];
+	u16 filter[FLOW_MASK_STAGES - 1][FLOW_STAGE_FILTER_SIZE];
+};
+
 struct mask_count {
 	int index;
 	u64 counter;
@@ -34,6 +34,7 @@
 
 #define TX_BATCH_SIZE 32
 #define MAX_PER_SOCKET_BUDGET (TX_BATCH_SIZE)
+#define TX_BULK_SIZE 16
 
 void xsk_set_rx_need_wakeup(struct xsk_buff_pool *pool)
 {
@@ -773,13 +774,94 @@ free_err:
 	return ERR_PTR(err);
 }
 
+/* Send a bulk of skbs to the device under a single tx lock, with
+ * xmit_more set on all but the last one. The descriptors of the skbs
+ * must be the last ones released from the TX ring, so that those of
+ * the skbs the device is too busy for can be given back.
+ *
+ * As in sch_direct_xmit(), the skbs are validated before taking the
+ * lock. A dropped skb is completed, so the valid skbs before it can no
+ * longer be given back: they are dropped too if the device is busy.
+ */
+static int xsk_generic_xmit_bulk(struct xdp_sock *xs, struct sk_buff **skbs,
+				 u32 nb_skbs, bool *sent_frame)
+{
+	u32 i, j, nb_valid = 0, nb_pinned = 0, nb_descs = 0;
+	struct net_device *dev = xs->dev;
+	struct netdev_queue *txq;
+	bool again = false;
+	int err = 0;
+
+	for (i = 0; i < nb_skbs; i++) {
+		struct sk_buff *skb = skbs[i];
+
+		if (likely(netif_running(dev) && netif_carrier_ok(dev))) {
+			skb = validate_xmit_skb_list(skb, dev, &again);
+			if (likely(skb == skbs[i])) {
+				skbs[nb_valid++] = skb;
+				continue;
+			}
+		}
+
+		/* SKB completed but not sent */
+		dev_core_stats_tx_dropped_inc(dev);
+		kfree_skb_list(skb);
+		nb_pinned = nb_valid;
+		err = -EBUSY;
+	}
+
+	txq = netdev_get_tx_queue(dev, xs->queue_id);
+
+	local_bh_disable();
+	HARD_TX_LOCK(dev, txq, smp_processor_id());
+	for (i = 0; i < nb_valid; i++) {
+		int ret;
+
+		if (netif_xmit_frozen_or_drv_stopped(txq))
+			break;
+
+		skb_set_queue_mapping(skbs[i], xs->queue_id);
+		ret = netdev_start_xmit(skbs[i], dev, txq, i + 1 < nb_valid);
+		if (!dev_xmit_complete(ret))
+			break;
+
+		/* Ignore NET_XMIT_CN as packet might have been sent */
+		if (ret == NET_XMIT_DROP)
+			err = -EBUSY;
+		else
+			*sent_frame = true;
+	}
+	HARD_TX_UNLOCK(dev, txq);
+	local_bh_enable();
+
+	for (; i < nb_pinned; i++) {
+		dev_core_stats_tx_dropped_inc(dev);
+		kfree_skb(skbs[i]);
+		err = -EBUSY;
+	}
+
+	if (i < nb_valid) {
+		/* Tell user-space to retry the send of the rest */
+		for (j = i; j < nb_valid; j++)
+			nb_descs += xsk_get_num_desc(skbs[j]);
+		xskq_cons_cancel_n(xs->tx, nb_descs);
+		for (j = i; j < nb_valid; j++)
+			xsk_consume_skb(skbs[j]);
+		err = -EAGAIN;
+	}
+
+	return err;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
 	struct xdp_sock *xs = xdp_sk(sk);
+	struct sk_buff *skbs[TX_BULK_SIZE];
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
 	struct xdp_desc desc;
 	struct sk_buff *skb;
+	u32 nb_skbs = 0;
 	int err = 0;
 
 	mutex_lock(&xs->mutex);
@@ -799,6 +881,16 @@ static int __xsk_generic_xmit(struct sock *sk)
 			goto out;
 		}
 
+		/* A multi-buffer packet may be dropped half-way, send the
+		 * bulk first to keep its descriptors the last ones released.
+		 */
+		if (nb_skbs && xp_mb_desc(&desc)) {
+			err = xsk_generic_xmit_bulk(xs, skbs, nb_skbs, &sent_frame);
+			nb_skbs = 0;
+			if (err)
+				goto out;
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
@@ -823,25 +915,25 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
-		}
+		xs->skb = NULL;
+		skbs[nb_skbs++] = skb;
 
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
-			goto out;
+		/* Send before the next peek publishes the consumer pointer,
+		 * the descriptors can no longer be given back after that.
+		 */
+		if (nb_skbs == TX_BULK_SIZE || !xskq_has_descs(xs->tx)) {
+			err = xsk_generic_xmit_bulk(xs, skbs, nb_skbs, &sent_frame);
+			nb_skbs = 0;
+			if (err)
+				goto out;
 		}
+	}
 
-		sent_frame = true;
-		xs->skb = NULL;
+	if (nb_skbs) {
+		err = xsk_generic_xmit_bulk(xs, skbs, nb_skbs, &sent_frame);
+		nb_skbs = 0;
+		if (err)
+			goto out;
 	}
 
 	if (xskq_has_descs(xs->tx)) {
@@ -851,6 +943,13 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (nb_skbs) {
+		int ret = xsk_generic_xmit_bulk(xs, skbs, nb_skbs, &sent_frame);
+
+		if (ret)
+			err = ret;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
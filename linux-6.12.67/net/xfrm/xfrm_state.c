@@ -1426,6 +1426,12 @@ found:
 	if (!(pol->flags & XFRM_POLICY_CPU_ACQUIRE) ||
 	    (best && (best->pcpu_num == pcpu_id)))
 		x = best;
+	else if (best && acquire_in_progress)
+		/* Keep using the 'fallback' until the CPU-specific SA
+		 * is installed, rather than holding back this CPU's
+		 * traffic for as long as the acquire is pending.
+		 */
+		x = best;
 
 	if (!x && !error && !acquire_in_progress) {
 		if (tmpl->id.spi &&
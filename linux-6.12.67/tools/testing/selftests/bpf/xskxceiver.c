@@ -97,6 +97,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "xsk_xdp_progs.skel.h"
@@ -366,6 +367,7 @@ static void print_usage(char **argv)
 		"  -m, --mode           Run only mode skb, drv, or zc\n"
 		"  -l, --list           List all available tests\n"
 		"  -t, --test           Run a specific test. Enter number from -l option.\n"
+		"                       Extended tests only run this way.\n"
 		"  -h, --help           Display this help and exit\n";
 
 	ksft_print_msg(str, basename(argv[0]));
@@ -2098,6 +2100,28 @@ static int testapp_single_pkt(struct test_spec *test)
 	return testapp_validate_traffic(test);
 }
 
+static int testapp_send_receive_pps(struct test_spec *test)
+{
+	u32 nb_pkts = 16 * DEFAULT_PKT_CNT;
+	struct timespec start, end;
+	u64 usecs;
+	int ret;
+
+	pkt_stream_replace(test, nb_pkts, MIN_PKT_SIZE);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	ret = testapp_validate_traffic(test);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (ret)
+		return ret;
+
+	usecs = (end.tv_sec - start.tv_sec) * 1000000ULL +
+		(end.tv_nsec - start.tv_nsec) / 1000;
+	ksft_print_msg("%u packets in %llu us: %llu pps\n", nb_pkts, usecs,
+		       nb_pkts * 1000000ULL / (usecs + 1));
+	return TEST_PASS;
+}
+
 static int testapp_send_receive_mb(struct test_spec *test)
 {
 	test->mtu = MAX_ETH_JUMBO_SIZE;
@@ -2621,6 +2645,8 @@ static const struct test_spec tests[] = {
 	{.name = "TOO_MANY_FRAGS", .test_func = testapp_too_many_frags},
 	{.name = "HW_SW_MIN_RING_SIZE", .test_func = testapp_hw_sw_min_ring_size},
 	{.name = "HW_SW_MAX_RING_SIZE", .test_func = testapp_hw_sw_max_ring_size},
+	/* Extended tests only run when selected with -t. */
+	{.name = "SEND_RECEIVE_PPS", .test_func = testapp_send_receive_pps, .extended = true},
 	};
 
 static void print_tests(void)
@@ -2629,7 +2655,8 @@ static void print_tests(void)
 
 	printf("Tests:\n");
 	for (i = 0; i < ARRAY_SIZE(tests); i++)
-		printf("%u: %s\n", i, tests[i].name);
+		printf("%u: %s%s\n", i, tests[i].name,
+		       tests[i].extended ? " (extended)" : "");
 }
 
 int main(int argc, char **argv)
@@ -2697,10 +2724,13 @@ int main(int argc, char **argv)
 	test.tx_pkt_stream_default = tx_pkt_stream_default;
 	test.rx_pkt_stream_default = rx_pkt_stream_default;
 
-	if (opt_run_test == RUN_ALL_TESTS)
-		nb_tests = ARRAY_SIZE(tests);
-	else
+	if (opt_run_test == RUN_ALL_TESTS) {
+		nb_tests = 0;
+		for (j = 0; j < ARRAY_SIZE(tests); j++)
+			nb_tests += !tests[j].extended;
+	} else {
 		nb_tests = 1;
+	}
 	if (opt_mode == TEST_MODE_ALL) {
 		ksft_set_plan(modes * nb_tests);
 	} else {
@@ -2723,6 +2753,8 @@ int main(int argc, char **argv)
 		for (j = 0; j < ARRAY_SIZE(tests); j++) {
 			if (opt_run_test != RUN_ALL_TESTS && j != opt_run_test)
 				continue;
+			if (opt_run_test == RUN_ALL_TESTS && tests[j].extended)
+				continue;
 
 			test_spec_init(&test, ifobj_tx, ifobj_rx, i, &tests[j]);
 			run_pkt_test(&test);
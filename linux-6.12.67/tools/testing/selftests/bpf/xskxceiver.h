@@ -173,6 +173,7 @@ struct test_spec {
 	u16 nb_sockets;
 	bool fail;
 	bool set_ring;
+	bool extended;
 	enum test_mode mode;
 	char name[MAX_TEST_NAME_SIZE];
 };
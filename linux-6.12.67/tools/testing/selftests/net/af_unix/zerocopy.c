@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "../../kselftest_harness.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY	0x4000000
+#endif
+
+#define BUF_SZ	(32 * 1024)
+
+FIXTURE(zerocopy)
+{
+	int fd[2];		/* 0: sender, 1: receiver */
+	char buf[BUF_SZ];
+	char rbuf[BUF_SZ];
+};
+
+FIXTURE_SETUP(zerocopy)
+{
+	int one = 1, ret, i;
+
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, self->fd);
+	ASSERT_EQ(0, ret);
+
+	ret = setsockopt(self->fd[0], SOL_SOCKET, SO_ZEROCOPY,
+			 &one, sizeof(one));
+	ASSERT_EQ(0, ret);
+
+	for (i = 0; i < BUF_SZ; i++)
+		self->buf[i] = 'a' + i % 26;
+}
+
+FIXTURE_TEARDOWN(zerocopy)
+{
+	close(self->fd[0]);
+	close(self->fd[1]);
+}
+
+static void recv_completion(struct __test_metadata *_metadata, int fd,
+			    __u32 lo, __u32 hi, bool copied)
+{
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct msghdr msg = {
+		.msg_control = control,
+		.msg_controllen = sizeof(control),
+	};
+	struct pollfd pfd = { .fd = fd };
+	struct sock_extended_err *serr;
+	struct cmsghdr *cmsg;
+	int ret;
+
+	ret = poll(&pfd, 1, 1000);
+	ASSERT_EQ(1, ret);
+	ASSERT_TRUE(pfd.revents & POLLERR);
+
+	ret = recvmsg(fd, &msg, MSG_ERRQUEUE);
+	ASSERT_EQ(0, ret);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	ASSERT_NE(NULL, cmsg);
+	ASSERT_EQ(SOL_IP, cmsg->cmsg_level);
+	ASSERT_EQ(IP_RECVERR, cmsg->cmsg_type);
+
+	serr = (struct sock_extended_err *)CMSG_DATA(cmsg);
+	ASSERT_EQ(SO_EE_ORIGIN_ZEROCOPY, serr->ee_origin);
+	ASSERT_EQ(0, serr->ee_errno);
+	ASSERT_EQ(lo, serr->ee_info);
+	ASSERT_EQ(hi, serr->ee_data);
+	ASSERT_EQ(copied ? SO_EE_CODE_ZEROCOPY_COPIED : 0, serr->ee_code);
+}
+
+TEST_F(zerocopy, recv)
+{
+	int ret;
+
+	ret = send(self->fd[0], self->buf, BUF_SZ, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SZ, ret);
+
+	ret = recv(self->fd[1], self->rbuf, BUF_SZ, MSG_WAITALL);
+	ASSERT_EQ(BUF_SZ, ret);
+	ASSERT_EQ(0, memcmp(self->buf, self->rbuf, BUF_SZ));
+
+	recv_completion(_metadata, self->fd[0], 0, 0, false);
+}
+
+TEST_F(zerocopy, recv_coalesced)
+{
+	int ret;
+
+	ret = send(self->fd[0], self->buf, BUF_SZ / 2, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SZ / 2, ret);
+
+	ret = send(self->fd[0], self->buf + BUF_SZ / 2, BUF_SZ / 2,
+		   MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SZ / 2, ret);
+
+	ret = recv(self->fd[1], self->rbuf, BUF_SZ, MSG_WAITALL);
+	ASSERT_EQ(BUF_SZ, ret);
+	ASSERT_EQ(0, memcmp(self->buf, self->rbuf, BUF_SZ));
+
+	recv_completion(_metadata, self->fd[0], 0, 1, false);
+}
+
+TEST_F(zerocopy, splice)
+{
+	int pipefd[2], ret, len = 0;
+
+	ret = pipe(pipefd);
+	ASSERT_EQ(0, ret);
+
+	ret = send(self->fd[0], self->buf, BUF_SZ, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SZ, ret);
+
+	while (len < BUF_SZ) {
+		ret = splice(self->fd[1], NULL, pipefd[1], NULL,
+			     BUF_SZ - len, 0);
+		ASSERT_LT(0, ret);
+
+		ret = read(pipefd[0], self->rbuf + len, ret);
+		ASSERT_LT(0, ret);
+		len += ret;
+	}
+	ASSERT_EQ(0, memcmp(self->buf, self->rbuf, BUF_SZ));
+
+	/* The pipe got a copy of the pages. */
+	recv_completion(_metadata, self->fd[0], 0, 0, true);
+
+	close(pipefd[0]);
+	close(pipefd[1]);
+}
+
+TEST_F(zerocopy, disabled)
+{
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct msghdr msg = {
+		.msg_control = control,
+		.msg_controllen = sizeof(control),
+	};
+	int zero = 0, ret;
+
+	ret = setsockopt(self->fd[0], SOL_SOCKET, SO_ZEROCOPY,
+			 &zero, sizeof(zero));
+	ASSERT_EQ(0, ret);
+
+	ret = send(self->fd[0], self->buf, BUF_SZ, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SZ, ret);
+
+	ret = recv(self->fd[1], self->rbuf, BUF_SZ, MSG_WAITALL);
+	ASSERT_EQ(BUF_SZ, ret);
+	ASSERT_EQ(0, memcmp(self->buf, self->rbuf, BUF_SZ));
+
+	ret = recvmsg(self->fd[0], &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+	ASSERT_EQ(-1, ret);
+	ASSERT_EQ(EAGAIN, errno);
+}
+
+TEST(zerocopy_dgram)
+{
+	int fd[2], one = 1, ret;
+
+	ret = socketpair(AF_UNIX, SOCK_DGRAM, 0, fd);
+	ASSERT_EQ(0, ret);
+
+	ret = setsockopt(fd[0], SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one));
+	ASSERT_EQ(-1, ret);
+	ASSERT_EQ(EOPNOTSUPP, errno);
+
+	close(fd[0]);
+	close(fd[1]);
+}
+
+TEST_HARNESS_MAIN
@@ -0,0 +1,69 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Measure linear rule evaluation cost of a long nftables chain.
+#
+# The chain is made of groups of rules that share the same leading
+# "ip daddr" match, none of which matches the test traffic, followed by
+# a rule counting the packets that made it to the end of the chain.
+
+source lib.sh
+
+[ "$KSFT_MACHINE_SLOW" = yes ] && exit ${ksft_skip}
+
+groups=${NFT_CHAIN_PERF_GROUPS:-256}
+rules_per_group=${NFT_CHAIN_PERF_RULES:-16}
+count=${NFT_CHAIN_PERF_COUNT:-100000}
+
+cleanup()
+{
+	cleanup_all_ns
+}
+
+checktool "nft --version" "run test without nft tool"
+checktool "ping -c 1 -W 1 127.0.0.1" "run test without ping"
+
+setup_ns ns1
+
+trap cleanup EXIT
+
+load_ruleset()
+{
+	local g r
+
+	(
+		echo "flush ruleset"
+		echo "table ip perf {"
+		echo "	counter passed {}"
+		echo "	chain output {"
+		echo "		type filter hook output priority 0; policy accept;"
+		for g in $(seq 1 "$groups"); do
+			for r in $(seq 1 "$rules_per_group"); do
+				echo "		ip daddr 10.$((g / 256)).$((g % 256)).1 icmp type echo-request icmp id $r counter"
+			done
+		done
+		echo "		icmp type echo-request counter name passed"
+		echo "	}"
+		echo "}"
+	) | ip netns exec "$ns1" nft -f /dev/stdin
+}
+
+if ! load_ruleset; then
+	echo "SKIP: Cannot add nftables rules"
+	exit $ksft_skip
+fi
+
+start=$(date +%s%N)
+ip netns exec "$ns1" ping -q -f -c "$count" 127.0.0.1 > /dev/null
+stop=$(date +%s%N)
+
+passed=$(ip netns exec "$ns1" nft list counter ip perf passed | grep packets | sed 's/.*packets \([0-9]*\).*/\1/')
+if [ "$passed" -ne "$count" ]; then
+	echo "FAIL: $passed packets reached end of chain, expected $count"
+	exit 1
+fi
+
+rules=$((groups * rules_per_group))
+usecs=$(((stop - start) / 1000))
+echo "PASS: $count packets through $rules rules in ${usecs}us ($((count * 1000000 / (usecs + 1))) pps)"
+exit 0
@@ -0,0 +1,134 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Measure the miss path of the datapath flow table lookup.
+#
+# The datapath gets flows with many different masks, none of which
+# matches the test traffic, so that every packet is looked up with all
+# the masks before being counted as a miss.  This is done twice:
+#
+#  l3: the masks differ by the IPv4 address prefixes, so the staged
+#      lookup gives up on a mask once the addresses miss its filter.
+#  l4: all flows match the addresses of the traffic and the masks
+#      differ by the UDP ports, so every mask is looked up down to the
+#      last stage, as it would be without the staged lookup.
+#
+# Comparing the two rates shows the gain of the early termination on
+# the running kernel.
+
+source ../lib.sh
+
+[ "$KSFT_MACHINE_SLOW" = yes ] && exit ${ksft_skip}
+
+masks=${OVS_FLOW_PERF_MASKS:-64}
+count=${OVS_FLOW_PERF_COUNT:-1000000}
+dpctl="python3 ovs-dpctl.py"
+
+cleanup()
+{
+	ip netns exec "$ns2" $dpctl del-dp perf > /dev/null 2>&1
+	cleanup_all_ns
+}
+
+if [ "$masks" -gt 64 ]; then
+	echo "SKIP: At most 64 distinct masks are supported"
+	exit $ksft_skip
+fi
+
+for tool in "python3 -c 'import pyroute2'" "mausezahn -V"; do
+	if ! eval "$tool" > /dev/null 2>&1; then
+		echo "SKIP: Could not run test without ${tool%% *}"
+		exit $ksft_skip
+	fi
+done
+
+setup_ns ns1 ns2
+
+trap cleanup EXIT
+
+ip link add veth0 netns "$ns1" type veth peer name veth1 netns "$ns2"
+ip -net "$ns1" link set veth0 up
+ip -net "$ns2" link set veth1 up
+
+if ! ip netns exec "$ns2" $dpctl add-dp perf; then
+	echo "SKIP: Cannot create an openvswitch datapath"
+	exit $ksft_skip
+fi
+ip netns exec "$ns2" $dpctl add-if perf veth1
+
+prefix_mask()
+{
+	local len=$1
+	local m=$(( (0xffffffff << (32 - len)) & 0xffffffff ))
+
+	echo "$((m >> 24)).$(((m >> 16) & 255)).$(((m >> 8) & 255)).$((m & 255))"
+}
+
+port_mask()
+{
+	echo $(( (0xffff << (16 - $1)) & 0xffff ))
+}
+
+l3_flow()
+{
+	local i=$1
+	local src=$((i % 32 + 1))
+	local dst=$((i / 32 * 8 + 8))
+
+	echo "in_port(1),eth(),eth_type(0x0800),ipv4(src=172.16.0.0/$(prefix_mask $src),dst=172.17.0.0/$(prefix_mask $dst))"
+}
+
+# The traffic uses ports 1 and 9, which never have the high bit the
+# flows ask for.
+l4_flow()
+{
+	local i=$1
+	local src=$((i % 16 + 1))
+	local dst=$((i / 16 * 4 + 4))
+
+	echo "in_port(1),eth(),eth_type(0x0800),ipv4(src=10.0.0.1,dst=10.0.0.2,proto=17),udp(src=32768/$(port_mask $src),dst=32768/$(port_mask $dst))"
+}
+
+missed()
+{
+	ip netns exec "$ns2" $dpctl show perf | sed -n 's/.*missed:\([0-9]*\).*/\1/p'
+}
+
+# Prints the miss rate in packets per second.
+run_case()
+{
+	local name=$1
+	local before after start stop usecs flow i
+
+	ip netns exec "$ns2" $dpctl del-flows perf
+	for i in $(seq 0 $((masks - 1))); do
+		flow=$(${name}_flow "$i")
+		if ! ip netns exec "$ns2" $dpctl add-flow perf "$flow" "drop"; then
+			echo "FAIL: Cannot add flow $flow" >&2
+			return 1
+		fi
+	done
+
+	before=$(missed)
+	start=$(date +%s%N)
+	ip netns exec "$ns1" mausezahn veth0 -q -c "$count" -d 0 -t udp \
+		-A 10.0.0.1 -B 10.0.0.2 "sp=1,dp=9"
+	stop=$(date +%s%N)
+	after=$(missed)
+
+	if [ $((${after:-0} - ${before:-0})) -lt "$count" ]; then
+		echo "FAIL: $name: $((after - before)) packets missed the flow table, expected $count" >&2
+		return 1
+	fi
+
+	usecs=$(((stop - start) / 1000))
+	echo "$((count * 1000000 / (usecs + 1)))"
+}
+
+l3_pps=$(run_case l3) || exit 1
+l4_pps=$(run_case l4) || exit 1
+
+echo "PASS: $count packets missed $masks masks"
+echo "  masks differing in L3 (early termination): $l3_pps pps"
+echo "  masks differing in L4 (full lookup):       $l4_pps pps"
+exit 0
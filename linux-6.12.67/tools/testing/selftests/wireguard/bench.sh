@@ -0,0 +1,64 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Measure small packet throughput through a WireGuard tunnel.
+#
+# Two namespaces are connected by a veth pair carrying the tunnel, and
+# iperf3 sends UDP datagrams of $LEN bytes (default 64) from one end of
+# the tunnel to the other. Run several times with different lengths to
+# see how the per-packet cost of the encryption scales.
+
+set -e
+
+len=${LEN:-64}
+duration=${DURATION:-10}
+netns1="wg-bench-$$-1"
+netns2="wg-bench-$$-2"
+
+n1() { ip netns exec $netns1 "$@"; }
+n2() { ip netns exec $netns2 "$@"; }
+
+cleanup() {
+	set +e
+	n1 pkill -x iperf3 2>/dev/null
+	n2 pkill -x iperf3 2>/dev/null
+	ip netns del $netns1 2>/dev/null
+	ip netns del $netns2 2>/dev/null
+}
+
+for tool in wg iperf3; do
+	if ! command -v $tool > /dev/null; then
+		echo "SKIP: $tool is required"
+		exit 4
+	fi
+done
+
+trap cleanup EXIT
+
+ip netns add $netns1
+ip netns add $netns2
+ip link add veth1 netns $netns1 type veth peer name veth2 netns $netns2
+n1 ip addr add 10.0.0.1/24 dev veth1
+n2 ip addr add 10.0.0.2/24 dev veth2
+n1 ip link set veth1 up
+n2 ip link set veth2 up
+
+key1="$(wg genkey)"
+key2="$(wg genkey)"
+pub1="$(wg pubkey <<<"$key1")"
+pub2="$(wg pubkey <<<"$key2")"
+
+n1 ip link add wg0 type wireguard
+n2 ip link add wg0 type wireguard
+n1 wg set wg0 private-key <(echo "$key1") listen-port 1 \
+	peer "$pub2" allowed-ips 192.168.241.2/32 endpoint 10.0.0.2:2
+n2 wg set wg0 private-key <(echo "$key2") listen-port 2 \
+	peer "$pub1" allowed-ips 192.168.241.1/32 endpoint 10.0.0.1:1
+n1 ip addr add 192.168.241.1/24 dev wg0
+n2 ip addr add 192.168.241.2/24 dev wg0
+n1 ip link set wg0 up
+n2 ip link set wg0 up
+
+n2 iperf3 -s -1 -B 192.168.241.2 -D
+sleep 1
+n1 iperf3 -Z -u -b 0 -l "$len" -t "$duration" -c 192.168.241.2 | tail -n 4